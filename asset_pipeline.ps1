@@ -77,6 +77,48 @@ function Invoke-CreateAssetSymlink() {
     }
 }
 
+function Invoke-PackAtlas() {
+    param (
+        [string] $platform,
+        [string] $configuration
+    );
+
+    # Pack sprites
+    # Every image in ./assets/sprites is packed into ./assets/atlas.bin with atlas_packer, along with
+    # ./assets/__generated__/atlas_preview*.png to look at the pages.
+    $sprite_dir = "$PSScriptRoot\$asset_dir\sprites"
+    $atlas_path = "$PSScriptRoot\$asset_dir\atlas.bin"
+    $preview_path = "$PSScriptRoot\$asset_dir\__generated__\atlas_preview.png"
+    $packer = "$PSScriptRoot\bin\atlas_packer\bin\$platform\$configuration\atlas_packer.exe"
+
+    if ($clean -eq $true) {
+        Write-Host "Removing packed atlas..."
+        Remove-Item $atlas_path -Force -ErrorAction Ignore | Out-Null
+        Remove-Item "$PSScriptRoot\$asset_dir\__generated__\atlas_preview*.png" -Force -ErrorAction Ignore | Out-Null
+        return
+    }
+
+    if (-not (Test-Path $sprite_dir -PathType Container)) {
+        Write-Host "Skipping atlas packing, there is no sprite directory at $sprite_dir."
+        return
+    }
+
+    if (-not (Test-Path $packer -PathType Leaf)) {
+        Write-Host "Skipping atlas packing, atlas_packer hasn't been built for $platform $configuration."
+        return
+    }
+
+    Write-Host "Packing sprites..."
+
+    New-Item -ItemType Directory (Split-Path $preview_path) -ErrorAction Ignore | Out-Null
+
+    $sprites = Get-ChildItem $sprite_dir\* -Include *.png | Sort-Object Name | ForEach-Object { $_.FullName }
+    & $packer -z -p $preview_path -o $atlas_path @sprites
+    if ($LASTEXITCODE -ne 0) {
+        throw "atlas_packer failed with exit code $LASTEXITCODE"
+    }
+}
+
 function Invoke-CompileShaders() {
     # Compile shaders
     # All shaders matching the pattern ./assets/shaders/*.glsl will be compiled into ./assets/shaders/__generated__/*.spv
@@ -108,6 +150,7 @@ $configuration_group = $configuration_groups[$configuration]
 foreach ($platform in $platform_group) {
     foreach ($configuration in $configuration_group) {
         Invoke-CreateAssetSymlink -platform $platform -configuration $configuration
+        Invoke-PackAtlas -platform $platform -configuration $configuration
     }
 }
 # Invoke-CompileShaders
@@ -1,16 +1,21 @@
 #version 330
 
-uniform sampler2D atlas;
+uniform sampler2DArray atlas;
 
 in vec2 uv;
 in vec4 color;
+flat in float page;
 
 out vec4 frag_color;
 
 void main()
 {
-    vec4 tex_color = texture(atlas, uv);
+    vec4 tex_color = texture(atlas, vec3(uv, page));
+#ifdef SPRITE_TINT
     frag_color.rgb = mix(tex_color.rgb, color.rgb, color.a);
+#else
+    frag_color.rgb = tex_color.rgb;
+#endif
     frag_color.a = tex_color.a;
     // if (frag_color.rgb == vec3(0, 0, 0)) {
     //     frag_color.a = 0.0;
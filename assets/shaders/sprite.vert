@@ -7,15 +7,18 @@ layout(location = 3) in vec4 spr_rect;   // pos: x,y -- size: z,w
 layout(location = 4) in vec2 spr_origin; // 0,0 : top left, 0.5,0.5: center, 1,1: bottom right
 layout(location = 5) in vec2 inst_scale;
 layout(location = 6) in vec4 inst_color;
+layout(location = 7) in float inst_page;
 
 uniform mat4 view_proj;
 out vec2 uv;
 out vec4 color;
+flat out float page;
 
 void main()
 {
     uv = texcoord0 * spr_rect.zw + spr_rect.xy;
     color = inst_color;
+    page = inst_page;
 
     vec2 origin = spr_origin * inst_scale;
     vec2 vert_pos = position * inst_scale;
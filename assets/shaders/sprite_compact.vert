@@ -0,0 +1,33 @@
+#version 330
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texcoord0;
+layout(location = 2) in vec3 inst_pos;
+layout(location = 3) in vec4 spr_tile;   // atlas tile: x,y (y counts rows across pages) -- size in tiles: z,w (negative is flipped)
+layout(location = 4) in vec2 spr_origin; // 0,0 : top left, 0.5,0.5: center, 1,1: bottom right
+layout(location = 5) in vec4 inst_color;
+
+uniform mat4 view_proj;
+out vec2 uv;
+out vec4 color;
+flat out float page;
+
+const float k_atlas_tiles = 16.0f;
+
+void main()
+{
+    // flipped axes start sampling from the far edge of the tile
+    vec2 inst_scale = abs(spr_tile.zw);
+    vec2 flip_offset = inst_scale - max(spr_tile.zw, vec2(0.0f));
+    vec2 tile = vec2(spr_tile.x, mod(spr_tile.y, k_atlas_tiles));
+    vec4 spr_rect = vec4(tile + flip_offset, spr_tile.zw) / k_atlas_tiles;
+    page = floor(spr_tile.y / k_atlas_tiles);
+
+    uv = texcoord0 * spr_rect.zw + spr_rect.xy;
+    color = inst_color;
+
+    vec2 origin = spr_origin * inst_scale;
+    vec2 vert_pos = position * inst_scale;
+    vec3 pos = vec3(vert_pos + inst_pos.xy - origin, inst_pos.z);
+    gl_Position = view_proj * vec4(pos, 1.0f);
+}
@@ -1,5 +1,10 @@
 VULKAN_SDK = os.getenv("VULKAN_SDK")
 
+newoption {
+    trigger = "headless",
+    description = "Build crypt against sokol's dummy backend, no GL context or GPU needed"
+}
+
 workspace "crypt"
     configurations { "Debug", "Release" }
     platforms { "Linux64", "Win64", "Win32" }
@@ -39,6 +44,8 @@ project "crypt"
     files "src/crypt/**.c"    
     cppdialect "C++latest"
     links { "cimgui" }
+    -- the asset pipeline runs atlas_packer after the build
+    dependson { "atlas_packer" }
     includedirs { "src/cimgui" }
     postbuildcommands { "powershell.exe -File ../../asset_pipeline.ps1 -target %{prj.name} -platform %{cfg.platform} -configuration %{cfg.buildcfg}" }
 
@@ -74,3 +81,31 @@ project "crypt"
         defines { "NDEBUG", "_NDEBUG" }
         optimize "On"
 
+    filter "options:headless"
+        kind "ConsoleApp"
+        defines { "CRYPT_HEADLESS=1" }
+
+project "atlas_packer"
+    kind "ConsoleApp"
+    language "C"
+    location "bin/atlas_packer"
+    files "src/atlas_packer/**.c"
+    includedirs { "src/crypt", "src/cimgui/imgui" }
+
+    filter "platforms:Win64"
+        system "Windows"
+        defines { "_CRT_SECURE_NO_WARNINGS" }
+        architecture "x86_64"
+
+    filter "platforms:Linux64"
+        system "Linux"
+        architecture "x86_64"
+        links { "m" }
+
+    filter "configurations:Debug"
+        defines { "DEBUG", "_DEBUG" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG", "_NDEBUG" }
+        optimize "On"
@@ -0,0 +1,250 @@
+// atlas_packer - packs individual sprite images into atlas pages and writes them out as an
+// atlas blob (see src/crypt/atlas_blob.h) that the renderer loads with a single read.
+//
+// Sprites are packed on the renderer's tile grid, every sprite is rounded up to whole tiles so it
+// can be addressed by sprite_id like the hand authored atlas.
+//
+// usage: atlas_packer [options] -o <out.bin> <sprite.png>...
+//   -o <file>   output blob
+//   -t <px>     tile size in pixels (default 8)
+//   -z          zlib compress the page pixels
+//   -p <file>   also write every page as a png for inspection, page n > 0 goes to <file>_n.png
+
+#include "atlas_blob.h"
+#include "zlib_write.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+
+enum { K_PAGE_TILES = 16, K_MAX_PAGES = 8 };
+
+struct source_sprite {
+    const char* path;
+    char name[ATLAS_BLOB_NAME_MAX];
+    stbi_uc* pixels;
+    int width;
+    int height;
+};
+
+static void sprite_name_from_path(const char* path, char* name)
+{
+    const char* base = path;
+    for (const char* c = path; *c; ++c) {
+        if (*c == '/' || *c == '\\') {
+            base = c + 1;
+        }
+    }
+
+    size_t len = strlen(base);
+    const char* ext = strrchr(base, '.');
+    if (ext) {
+        len = (size_t)(ext - base);
+    }
+    if (len >= ATLAS_BLOB_NAME_MAX) {
+        len = ATLAS_BLOB_NAME_MAX - 1;
+    }
+
+    memset(name, 0, ATLAS_BLOB_NAME_MAX);
+    memcpy(name, base, len);
+}
+
+static int usage(void)
+{
+    fprintf(
+        stderr,
+        "usage: atlas_packer [-t tile_px] [-z] [-p preview.png] -o out.bin sprite.png...\n");
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    const char* out_path = NULL;
+    const char* preview_path = NULL;
+    int tile_px = 8;
+    int compress = 0;
+
+    struct source_sprite* sprites =
+        (struct source_sprite*)calloc(argc, sizeof(struct source_sprite));
+    int sprite_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            preview_path = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            tile_px = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-z") == 0) {
+            compress = 1;
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            sprites[sprite_count++].path = argv[i];
+        }
+    }
+
+    if (!out_path || sprite_count == 0 || tile_px <= 0) {
+        return usage();
+    }
+
+    const int page_px = tile_px * K_PAGE_TILES;
+
+    // load every sprite and convert its size to tiles for the packer
+    stbrp_rect* rects = (stbrp_rect*)calloc(sprite_count, sizeof(stbrp_rect));
+    for (int i = 0; i < sprite_count; ++i) {
+        struct source_sprite* s = &sprites[i];
+        int chan;
+        s->pixels = stbi_load(s->path, &s->width, &s->height, &chan, 4);
+        if (!s->pixels) {
+            fprintf(stderr, "failed to load %s: %s\n", s->path, stbi_failure_reason());
+            return 1;
+        }
+
+        sprite_name_from_path(s->path, s->name);
+
+        rects[i].id = i;
+        rects[i].w = (stbrp_coord)((s->width + tile_px - 1) / tile_px);
+        rects[i].h = (stbrp_coord)((s->height + tile_px - 1) / tile_px);
+
+        if (rects[i].w > K_PAGE_TILES || rects[i].h > K_PAGE_TILES) {
+            fprintf(stderr, "%s is larger than an atlas page (%dpx)\n", s->path, page_px);
+            return 1;
+        }
+    }
+
+    // fill pages one at a time, whatever didn't fit moves on to the next page
+    int* sprite_page = (int*)calloc(sprite_count, sizeof(int));
+    stbrp_rect* placed = (stbrp_rect*)calloc(sprite_count, sizeof(stbrp_rect));
+    stbrp_node nodes[K_PAGE_TILES];
+
+    int page_count = 0;
+    int placed_count = 0;
+    int remaining = sprite_count;
+    while (remaining > 0) {
+        if (page_count == K_MAX_PAGES) {
+            fprintf(stderr, "sprites don't fit in %d atlas pages\n", K_MAX_PAGES);
+            return 1;
+        }
+
+        stbrp_context ctx;
+        stbrp_init_target(&ctx, K_PAGE_TILES, K_PAGE_TILES, nodes, K_PAGE_TILES);
+        stbrp_pack_rects(&ctx, rects, remaining);
+
+        int pending = 0;
+        for (int i = 0; i < remaining; ++i) {
+            if (rects[i].was_packed) {
+                sprite_page[rects[i].id] = page_count;
+                placed[placed_count++] = rects[i];
+            } else {
+                rects[pending++] = rects[i];
+            }
+        }
+
+        remaining = pending;
+        ++page_count;
+    }
+
+    const size_t page_bytes = (size_t)page_px * page_px * 4;
+    const size_t pixels_size = page_bytes * page_count;
+    unsigned char* pixels = (unsigned char*)calloc(1, pixels_size);
+
+    struct atlas_blob_sprite* table =
+        (struct atlas_blob_sprite*)calloc(sprite_count, sizeof(struct atlas_blob_sprite));
+
+    for (int r = 0; r < placed_count; ++r) {
+        const stbrp_rect* rect = &placed[r];
+        const struct source_sprite* s = &sprites[rect->id];
+        const int page = sprite_page[rect->id];
+
+        unsigned char* dst = pixels + page_bytes * page;
+        for (int y = 0; y < s->height; ++y) {
+            memcpy(
+                dst + ((size_t)(rect->y * tile_px + y) * page_px + rect->x * tile_px) * 4,
+                s->pixels + (size_t)y * s->width * 4,
+                (size_t)s->width * 4);
+        }
+
+        struct atlas_blob_sprite* entry = &table[rect->id];
+        memcpy(entry->name, s->name, ATLAS_BLOB_NAME_MAX);
+        entry->sprite_id =
+            (uint16_t)(page * K_PAGE_TILES * K_PAGE_TILES + rect->y * K_PAGE_TILES + rect->x);
+        entry->width = (uint8_t)rect->w;
+        entry->height = (uint8_t)rect->h;
+        entry->uv[0] = (float)rect->x / K_PAGE_TILES;
+        entry->uv[1] = (float)rect->y / K_PAGE_TILES;
+        entry->uv[2] = (float)s->width / page_px;
+        entry->uv[3] = (float)s->height / page_px;
+    }
+
+    unsigned char* packed = pixels;
+    size_t packed_size = pixels_size;
+    if (compress) {
+        packed = zlib_compress(pixels, pixels_size, &packed_size);
+    }
+
+    struct atlas_blob_header header = {
+        .magic = ATLAS_BLOB_MAGIC,
+        .version = ATLAS_BLOB_VERSION,
+        .page_width = (uint16_t)page_px,
+        .page_height = (uint16_t)page_px,
+        .page_count = (uint16_t)page_count,
+        .page_tiles = K_PAGE_TILES,
+        .sprite_count = (uint32_t)sprite_count,
+        .compression = compress ? AtlasBlobCompression_Zlib : AtlasBlobCompression_None,
+        .pixels_size = (uint32_t)pixels_size,
+        .pixels_packed_size = (uint32_t)packed_size,
+    };
+
+    FILE* out = fopen(out_path, "wb");
+    if (!out) {
+        fprintf(stderr, "failed to open %s for writing\n", out_path);
+        return 1;
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(table, sizeof(struct atlas_blob_sprite), sprite_count, out);
+    fwrite(packed, 1, packed_size, out);
+    fclose(out);
+
+    if (preview_path) {
+        char page_path[1024];
+        const char* ext = strrchr(preview_path, '.');
+        const int stem = (int)((ext) ? ext - preview_path : strlen(preview_path));
+
+        for (int page = 0; page < page_count; ++page) {
+            if (page == 0) {
+                snprintf(page_path, sizeof(page_path), "%s", preview_path);
+            } else {
+                snprintf(
+                    page_path,
+                    sizeof(page_path),
+                    "%.*s_%d%s",
+                    stem,
+                    preview_path,
+                    page,
+                    (ext) ? ext : "");
+            }
+
+            if (!png_write_rgba(page_path, page_px, page_px, pixels + page_bytes * page)) {
+                fprintf(stderr, "failed to write preview %s\n", page_path);
+                return 1;
+            }
+        }
+    }
+
+    printf(
+        "packed %d sprites into %d page(s) of %dx%d, %zu bytes of pixels\n",
+        sprite_count,
+        page_count,
+        page_px,
+        page_px,
+        packed_size);
+
+    return 0;
+}
@@ -0,0 +1,289 @@
+#include "zlib_write.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    K_WINDOW_SIZE = 32768,
+    K_MIN_MATCH = 3,
+    K_MAX_MATCH = 258,
+    K_HASH_BITS = 15,
+    K_MAX_CHAIN = 64,
+};
+
+// deflate length and distance codes (rfc1951 3.2.5)
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+struct bit_writer {
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+    uint32_t bits;
+    int32_t bit_count;
+};
+
+static void put_byte(struct bit_writer* w, unsigned char byte)
+{
+    if (w->size == w->capacity) {
+        w->capacity = (w->capacity) ? w->capacity * 2 : 4096;
+        w->data = (unsigned char*)realloc(w->data, w->capacity);
+    }
+    w->data[w->size++] = byte;
+}
+
+// deflate packs values starting from the least significant bit
+static void put_bits(struct bit_writer* w, uint32_t value, int32_t count)
+{
+    w->bits |= value << w->bit_count;
+    w->bit_count += count;
+    while (w->bit_count >= 8) {
+        put_byte(w, (unsigned char)w->bits);
+        w->bits >>= 8;
+        w->bit_count -= 8;
+    }
+}
+
+// huffman codes are stored most significant bit first
+static void put_code(struct bit_writer* w, uint32_t code, int32_t count)
+{
+    uint32_t reversed = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    put_bits(w, reversed, count);
+}
+
+static void put_literal(struct bit_writer* w, uint32_t symbol)
+{
+    if (symbol < 144) {
+        put_code(w, 0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        put_code(w, 0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        put_code(w, symbol - 256, 7);
+    } else {
+        put_code(w, 0xc0 + symbol - 280, 8);
+    }
+}
+
+static void put_match(struct bit_writer* w, int32_t length, int32_t dist)
+{
+    int32_t l = 28;
+    while (length_base[l] > length) {
+        --l;
+    }
+    put_literal(w, 257 + l);
+    put_bits(w, length - length_base[l], length_extra[l]);
+
+    int32_t d = 29;
+    while (dist_base[d] > dist) {
+        --d;
+    }
+    put_code(w, d, 5);
+    put_bits(w, dist - dist_base[d], dist_extra[d]);
+}
+
+static uint32_t hash3(const unsigned char* p)
+{
+    const uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> (32 - K_HASH_BITS);
+}
+
+static uint32_t adler32(const unsigned char* data, size_t size)
+{
+    uint32_t a = 1, b = 0;
+    while (size > 0) {
+        // largest run that can't overflow before the modulo
+        size_t run = (size < 5552) ? size : 5552;
+        size -= run;
+        while (run--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+unsigned char* zlib_compress(const unsigned char* data, size_t size, size_t* out_size)
+{
+    struct bit_writer w = {0};
+    put_byte(&w, 0x78);
+    put_byte(&w, 0x5e);
+
+    // one fixed huffman block for everything
+    put_bits(&w, 1, 1);
+    put_bits(&w, 1, 2);
+
+    int32_t* head = (int32_t*)malloc(sizeof(int32_t) << K_HASH_BITS);
+    int32_t* prev = (int32_t*)malloc(sizeof(int32_t) * K_WINDOW_SIZE);
+    memset(head, 0xff, sizeof(int32_t) << K_HASH_BITS);
+
+    size_t pos = 0;
+    while (pos < size) {
+        int32_t best_length = 0;
+        int32_t best_dist = 0;
+
+        if (pos + K_MIN_MATCH <= size) {
+            const uint32_t h = hash3(data + pos);
+            const size_t max_length = (size - pos < K_MAX_MATCH) ? size - pos : K_MAX_MATCH;
+
+            int32_t candidate = head[h];
+            for (int32_t chain = 0; candidate >= 0 && chain < K_MAX_CHAIN; ++chain) {
+                const size_t dist = pos - (size_t)candidate;
+                if (dist > K_WINDOW_SIZE) {
+                    break;
+                }
+
+                size_t length = 0;
+                while (length < max_length && data[candidate + length] == data[pos + length]) {
+                    ++length;
+                }
+                if ((int32_t)length > best_length) {
+                    best_length = (int32_t)length;
+                    best_dist = (int32_t)dist;
+                    if (length == max_length) {
+                        break;
+                    }
+                }
+
+                const int32_t next = prev[candidate % K_WINDOW_SIZE];
+                if (next >= candidate) {
+                    break;
+                }
+                candidate = next;
+            }
+        }
+
+        const size_t advance = (best_length >= K_MIN_MATCH) ? (size_t)best_length : 1;
+        if (best_length >= K_MIN_MATCH) {
+            put_match(&w, best_length, best_dist);
+        } else {
+            put_literal(&w, data[pos]);
+        }
+
+        // every position covered gets into the chains so later runs can match against it
+        for (size_t i = 0; i < advance; ++i, ++pos) {
+            if (pos + K_MIN_MATCH <= size) {
+                const uint32_t h = hash3(data + pos);
+                prev[pos % K_WINDOW_SIZE] = head[h];
+                head[h] = (int32_t)pos;
+            }
+        }
+    }
+
+    free(head);
+    free(prev);
+
+    put_literal(&w, 256);
+    if (w.bit_count > 0) {
+        put_bits(&w, 0, 8 - w.bit_count);
+    }
+
+    const uint32_t check = adler32(data, size);
+    put_byte(&w, (unsigned char)(check >> 24));
+    put_byte(&w, (unsigned char)(check >> 16));
+    put_byte(&w, (unsigned char)(check >> 8));
+    put_byte(&w, (unsigned char)check);
+
+    *out_size = w.size;
+    return w.data;
+}
+
+static uint32_t crc32(uint32_t crc, const unsigned char* data, size_t size)
+{
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int32_t k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put_u32_be(unsigned char* out, uint32_t value)
+{
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+static void write_chunk(FILE* file, const char* type, const unsigned char* data, size_t size)
+{
+    unsigned char prefix[8];
+    put_u32_be(prefix, (uint32_t)size);
+    memcpy(prefix + 4, type, 4);
+
+    unsigned char crc[4];
+    put_u32_be(crc, crc32(crc32(0, prefix + 4, 4), data, size));
+
+    fwrite(prefix, 1, 8, file);
+    if (size > 0) {
+        fwrite(data, 1, size, file);
+    }
+    fwrite(crc, 1, 4, file);
+}
+
+int png_write_rgba(const char* path, int width, int height, const unsigned char* pixels)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return 0;
+    }
+
+    // every scanline gets filter type 0, the atlas pages compress fine without prediction
+    const size_t stride = (size_t)width * 4;
+    unsigned char* rows = (unsigned char*)malloc((stride + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        rows[(stride + 1) * y] = 0;
+        memcpy(rows + (stride + 1) * y + 1, pixels + stride * y, stride);
+    }
+
+    size_t idat_size;
+    unsigned char* idat = zlib_compress(rows, (stride + 1) * height, &idat_size);
+    free(rows);
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    unsigned char ihdr[13] = {0};
+    put_u32_be(ihdr, (uint32_t)width);
+    put_u32_be(ihdr + 4, (uint32_t)height);
+    ihdr[8] = 8; // bit depth
+    ihdr[9] = 6; // rgba
+
+    fwrite(signature, 1, sizeof(signature), file);
+    write_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+    write_chunk(file, "IDAT", idat, idat_size);
+    write_chunk(file, "IEND", NULL, 0);
+    free(idat);
+
+    const int ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
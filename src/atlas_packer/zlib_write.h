@@ -0,0 +1,15 @@
+// zlib_write.h - zlib and png output for atlas_packer
+// Just enough of a compressor for the packer's own output so the tool doesn't need an image writing
+// library. Deflate uses the fixed huffman tables with a hash chain match finder, that gets atlas
+// pages (mostly empty or flat colored tiles) most of the way to what a full deflate would. The
+// streams are plain zlib, the runtime reads them with stbi_zlib_decode_buffer like any other.
+
+#pragma once
+
+#include <stddef.h>
+
+// Returns a malloc'd zlib stream of data, free it with free.
+unsigned char* zlib_compress(const unsigned char* data, size_t size, size_t* out_size);
+
+// Writes a width * height 8 bit rgba image as a png, returns 0 on failure.
+int png_write_rgba(const char* path, int width, int height, const unsigned char* pixels);
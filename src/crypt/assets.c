@@ -0,0 +1,499 @@
+#include "assets.h"
+#include "hash.h"
+#include "render_cmds.h"
+#include "stb_ds.h"
+#include "stb_image.h"
+
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { K_MAX_ASSETS = 128, K_ASSET_PATH_MAX = 128 };
+
+// An image handed to the render thread, the slot stays loading until done is set.
+struct image_upload {
+    SDL_atomic_t done;
+    sg_image image;
+    int32_t width;
+    int32_t height;
+    int32_t layer_count;
+    uint8_t* pixels;
+};
+
+struct asset_slot {
+    // main thread only
+    bool in_use;
+    uint16_t generation;
+    int32_t refs;
+    uint32_t key;
+    asset_state state;
+    sg_image image;
+    struct image_upload* upload;
+
+    // written by the main thread before the slot is queued, read by the I/O thread
+    asset_type type;
+    int32_t layer_count;
+    char paths[ASSET_MAX_LAYERS][K_ASSET_PATH_MAX];
+
+    // written by the I/O thread before the slot is put on the completed queue
+    tx_result result;
+    file_view file;
+    int32_t width;
+    int32_t height;
+    uint8_t* pixels;
+};
+
+struct asset_loader {
+    struct asset_slot slots[K_MAX_ASSETS];
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* completed_cond;
+    SDL_sem* request_sem;
+    SDL_atomic_t quit;
+    // slot indices, both guarded by lock
+    int32_t* requests;
+    int32_t* completed;
+    // main thread copy of completed while the slots are being completed
+    int32_t* completing;
+    // slots waiting for their image upload, main thread only
+    int32_t* uploading;
+};
+
+static struct asset_loader loader = {0};
+
+static asset_handle make_handle(int32_t slot)
+{
+    return (asset_handle){.id = ((uint32_t)loader.slots[slot].generation << 16) | (slot + 1)};
+}
+
+static struct asset_slot* get_slot(asset_handle handle)
+{
+    int32_t slot = (int32_t)(handle.id & 0xffff) - 1;
+    if (!VALID_INDEX(slot, K_MAX_ASSETS)) {
+        return NULL;
+    }
+
+    struct asset_slot* s = &loader.slots[slot];
+    if (!s->in_use || s->generation != (uint16_t)(handle.id >> 16)) {
+        return NULL;
+    }
+    return s;
+}
+
+// render thread
+static void upload_image(void* data)
+{
+    struct image_upload* upload = *(struct image_upload**)data;
+
+    upload->image = sg_make_image(&(sg_image_desc){
+        .type = SG_IMAGETYPE_ARRAY,
+        .width = upload->width,
+        .height = upload->height,
+        .layers = upload->layer_count,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .content.subimage[0][0] =
+            {
+                .ptr = upload->pixels,
+                .size = upload->width * upload->height * 4 * upload->layer_count,
+            },
+    });
+
+    free(upload->pixels);
+    upload->pixels = NULL;
+
+    // full barrier, the image is visible to the main thread before done is
+    SDL_AtomicSet(&upload->done, 1);
+}
+
+static void destroy_image(void* data)
+{
+    sg_destroy_image(*(sg_image*)data);
+}
+
+static void free_slot(struct asset_slot* s, bool destroy_gpu)
+{
+    file_unmap(&s->file);
+    free(s->pixels);
+    if (s->upload) {
+        free(s->upload->pixels);
+        free(s->upload);
+    }
+    if (destroy_gpu && s->image.id != SG_INVALID_ID) {
+        render_cmd_push(RenderCmdStage_Frame, destroy_image, &s->image, sizeof(sg_image));
+    }
+
+    uint16_t generation = s->generation + 1;
+    memset(s, 0, sizeof(struct asset_slot));
+    s->generation = generation;
+}
+
+// I/O thread
+static void load_image_array(struct asset_slot* s)
+{
+    for (int32_t layer = 0; layer < s->layer_count; ++layer) {
+        file_view file;
+        s->result = file_map(s->paths[layer], &file);
+        if (s->result != TX_SUCCESS) {
+            return;
+        }
+
+        int w, h, chan;
+        stbi_uc* pixels =
+            stbi_load_from_memory((const stbi_uc*)file.data, (int)file.len, &w, &h, &chan, 4);
+        file_unmap(&file);
+
+        if (!pixels) {
+            s->result = TX_PARSE_ERROR;
+            return;
+        }
+
+        if (layer == 0) {
+            s->width = w;
+            s->height = h;
+            s->pixels = (uint8_t*)malloc((size_t)w * h * 4 * s->layer_count);
+        }
+
+        // every layer of a texture array has the same size
+        if (w != s->width || h != s->height || !s->pixels) {
+            stbi_image_free(pixels);
+            s->result = TX_INVALID_PARAMTER;
+            return;
+        }
+
+        memcpy(&s->pixels[(size_t)w * h * 4 * layer], pixels, (size_t)w * h * 4);
+        stbi_image_free(pixels);
+    }
+}
+
+static int asset_io_main(void* data)
+{
+    for (;;) {
+        SDL_SemWait(loader.request_sem);
+
+        if (SDL_AtomicGet(&loader.quit)) {
+            break;
+        }
+
+        SDL_LockMutex(loader.lock);
+        int32_t slot = loader.requests[0];
+        arrdel(loader.requests, 0);
+        SDL_UnlockMutex(loader.lock);
+
+        struct asset_slot* s = &loader.slots[slot];
+        switch (s->type) {
+        case AssetType_File:
+            s->result = file_map(s->paths[0], &s->file);
+            break;
+        case AssetType_ImageArray:
+            load_image_array(s);
+            break;
+        }
+
+        SDL_LockMutex(loader.lock);
+        arrput(loader.completed, slot);
+        SDL_CondBroadcast(loader.completed_cond);
+        SDL_UnlockMutex(loader.lock);
+    }
+
+    return 0;
+}
+
+// main thread
+static void complete_slot(int32_t slot)
+{
+    struct asset_slot* s = &loader.slots[slot];
+
+    // everyone let go of it while it was loading
+    if (s->refs == 0) {
+        free_slot(s, true);
+        return;
+    }
+
+    if (s->result != TX_SUCCESS) {
+        s->state = AssetState_Failed;
+        return;
+    }
+
+    // images are ready once the render thread has uploaded them, the pixels go with the upload
+    if (s->type == AssetType_ImageArray) {
+        s->upload = malloc(sizeof(struct image_upload));
+        *s->upload = (struct image_upload){
+            .width = s->width,
+            .height = s->height,
+            .layer_count = s->layer_count,
+            .pixels = s->pixels,
+        };
+        s->pixels = NULL;
+
+        render_cmd_push(RenderCmdStage_Frame, upload_image, &s->upload, sizeof(s->upload));
+        arrput(loader.uploading, slot);
+        return;
+    }
+
+    s->state = AssetState_Ready;
+}
+
+static void complete_image_uploads(void)
+{
+    for (int32_t i = 0; i < arrlen(loader.uploading);) {
+        struct asset_slot* s = &loader.slots[loader.uploading[i]];
+        if (!SDL_AtomicGet(&s->upload->done)) {
+            ++i;
+            continue;
+        }
+
+        s->image = s->upload->image;
+        free(s->upload);
+        s->upload = NULL;
+        arrdel(loader.uploading, i);
+
+        // released while it was uploading
+        if (s->refs == 0) {
+            free_slot(s, true);
+        } else {
+            s->state = AssetState_Ready;
+        }
+    }
+}
+
+static void complete_asset_loads(void)
+{
+    // take the finished slots so the I/O thread isn't held up by the uploads
+    SDL_LockMutex(loader.lock);
+    int32_t len = (int32_t)arrlen(loader.completed);
+    arrsetlen(loader.completing, len);
+    memcpy(loader.completing, loader.completed, sizeof(int32_t) * len);
+    arrsetlen(loader.completed, 0);
+    SDL_UnlockMutex(loader.lock);
+
+    for (int32_t i = 0; i < len; ++i) {
+        complete_slot(loader.completing[i]);
+    }
+
+    complete_image_uploads();
+}
+
+// the key only narrows the search, two different requests can hash the same
+static bool slot_matches(
+    const struct asset_slot* s,
+    uint32_t key,
+    asset_type type,
+    const char* const* paths,
+    int32_t count)
+{
+    if (s->key != key || s->type != type || s->layer_count != count) {
+        return false;
+    }
+    for (int32_t i = 0; i < count; ++i) {
+        if (strcmp(s->paths[i], paths[i]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static asset_handle asset_request(
+    asset_type type, const char* const* paths, int32_t count, bool shared)
+{
+    TX_ASSERT(count > 0 && count <= ASSET_MAX_LAYERS);
+
+    // a truncated path would load (or share) some other file
+    for (int32_t i = 0; i < count; ++i) {
+        if (strlen(paths[i]) >= K_ASSET_PATH_MAX) {
+            ecs_os_err("asset path is too long (%d max): %s", K_ASSET_PATH_MAX - 1, paths[i]);
+            return (asset_handle){0};
+        }
+    }
+
+    uint32_t key = hash_data(&type, sizeof(type));
+    for (int32_t i = 0; i < count; ++i) {
+        key ^= hash_string(paths[i]) + 0x9e3779b9 + (key << 6) + (key >> 2);
+    }
+
+    int32_t free_slot_id = -1;
+    for (int32_t i = 0; i < K_MAX_ASSETS; ++i) {
+        struct asset_slot* s = &loader.slots[i];
+        if (shared && s->in_use && s->refs > 0 && slot_matches(s, key, type, paths, count)) {
+            s->refs++;
+            return make_handle(i);
+        }
+        if (!s->in_use && free_slot_id < 0) {
+            free_slot_id = i;
+        }
+    }
+
+    TX_ASSERT(free_slot_id >= 0);
+    if (free_slot_id < 0) {
+        return (asset_handle){0};
+    }
+
+    struct asset_slot* s = &loader.slots[free_slot_id];
+    s->in_use = true;
+    s->refs = 1;
+    s->key = key;
+    s->state = AssetState_Loading;
+    s->type = type;
+    s->layer_count = count;
+    for (int32_t i = 0; i < count; ++i) {
+        memcpy(s->paths[i], paths[i], strlen(paths[i]) + 1);
+    }
+
+    SDL_LockMutex(loader.lock);
+    arrput(loader.requests, free_slot_id);
+    SDL_UnlockMutex(loader.lock);
+    SDL_SemPost(loader.request_sem);
+
+    return make_handle(free_slot_id);
+}
+
+asset_handle asset_load_file(const char* path)
+{
+    return asset_request(AssetType_File, &path, 1, true);
+}
+
+asset_handle asset_load_image_array(const char* const* paths, int32_t count)
+{
+    return asset_request(AssetType_ImageArray, paths, count, true);
+}
+
+asset_handle asset_reload(asset_handle handle)
+{
+    struct asset_slot* s = get_slot(handle);
+    if (!s) {
+        return (asset_handle){0};
+    }
+
+    const char* paths[ASSET_MAX_LAYERS];
+    for (int32_t i = 0; i < s->layer_count; ++i) {
+        paths[i] = s->paths[i];
+    }
+
+    return asset_request(s->type, paths, s->layer_count, false);
+}
+
+asset_state asset_get_state(asset_handle handle)
+{
+    struct asset_slot* s = get_slot(handle);
+    return (s) ? s->state : AssetState_Invalid;
+}
+
+const file_view* asset_get_file(asset_handle handle)
+{
+    struct asset_slot* s = get_slot(handle);
+    if (!s || s->state != AssetState_Ready || s->type != AssetType_File) {
+        return NULL;
+    }
+    return &s->file;
+}
+
+sg_image asset_get_image(asset_handle handle)
+{
+    struct asset_slot* s = get_slot(handle);
+    if (!s || s->state != AssetState_Ready) {
+        return (sg_image){SG_INVALID_ID};
+    }
+    return s->image;
+}
+
+asset_state asset_wait(asset_handle handle)
+{
+    struct asset_slot* s = get_slot(handle);
+    if (!s) {
+        return AssetState_Invalid;
+    }
+
+    if (s->state == AssetState_Loading) {
+        int32_t slot = (int32_t)(handle.id & 0xffff) - 1;
+
+        SDL_LockMutex(loader.lock);
+        for (;;) {
+            bool done = false;
+            for (int32_t i = 0; i < arrlen(loader.completed); ++i) {
+                done |= loader.completed[i] == slot;
+            }
+            if (done) {
+                break;
+            }
+            SDL_CondWait(loader.completed_cond, loader.lock);
+        }
+        SDL_UnlockMutex(loader.lock);
+
+        complete_asset_loads();
+    }
+
+    return s->state;
+}
+
+void asset_release(asset_handle handle)
+{
+    struct asset_slot* s = get_slot(handle);
+    if (!s || s->refs == 0) {
+        return;
+    }
+
+    // slots still being loaded are freed once the I/O thread (or the upload) hands them back
+    if (--s->refs == 0 && s->state != AssetState_Loading) {
+        free_slot(s, true);
+    }
+}
+
+void CompleteAssetLoads(ecs_iter_t* it)
+{
+    complete_asset_loads();
+}
+
+void ReleaseAssetRef(ecs_iter_t* it)
+{
+    AssetRef* ref = ecs_term(it, AssetRef, 1);
+
+    for (int32_t i = 0; i < it->count; ++i) {
+        asset_release(ref[i].handle);
+    }
+}
+
+void assets_fini(ecs_world_t* world, void* ctx)
+{
+    SDL_AtomicSet(&loader.quit, 1);
+    SDL_SemPost(loader.request_sem);
+    SDL_WaitThread(loader.thread, NULL);
+
+    // the gpu is shut down by now, sg_shutdown already released any images
+    for (int32_t i = 0; i < K_MAX_ASSETS; ++i) {
+        if (loader.slots[i].in_use) {
+            free_slot(&loader.slots[i], false);
+        }
+    }
+
+    arrfree(loader.requests);
+    arrfree(loader.completed);
+    arrfree(loader.completing);
+    arrfree(loader.uploading);
+    SDL_DestroySemaphore(loader.request_sem);
+    SDL_DestroyCond(loader.completed_cond);
+    SDL_DestroyMutex(loader.lock);
+
+    memset(&loader, 0, sizeof(struct asset_loader));
+}
+
+void AssetsImport(ecs_world_t* world)
+{
+    ECS_MODULE(world, Assets);
+
+    loader.lock = SDL_CreateMutex();
+    loader.completed_cond = SDL_CreateCond();
+    loader.request_sem = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&loader.quit, 0);
+    loader.thread = SDL_CreateThread(asset_io_main, "asset_io", NULL);
+    TX_ASSERT(loader.thread);
+
+    ecs_atfini(world, assets_fini, NULL);
+
+    ECS_COMPONENT(world, AssetRef);
+
+    ECS_SYSTEM(world, CompleteAssetLoads, EcsOnLoad, 0);
+    ECS_SYSTEM(world, ReleaseAssetRef, EcsUnSet, AssetRef);
+
+    ECS_EXPORT_COMPONENT(AssetRef);
+}
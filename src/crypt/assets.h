@@ -0,0 +1,59 @@
+// assets.h - Asynchronous Asset Loading
+// Assets are requested by path and read (and decoded) on a background I/O thread. Finished loads
+// are completed on the main thread by the CompleteAssetLoads system in EcsOnLoad, images are
+// uploaded by the render thread (see render_cmds.h) and become ready in a later CompleteAssetLoads.
+// Systems only ever see assets that are fully ready.
+// Requests for a path that is already loaded or in flight share the same asset. Paths of 128
+// characters or more are rejected with an invalid handle.
+
+#pragma once
+
+#include "flecs.h"
+#include "futils.h"
+#include "sokol_gfx.h"
+#include "tx_types.h"
+
+enum { ASSET_MAX_LAYERS = 8 };
+
+typedef struct asset_handle {
+    uint32_t id; // generation << 16 | slot + 1, 0 is never a valid asset
+} asset_handle;
+
+typedef enum asset_type {
+    // raw file contents, see asset_get_file
+    AssetType_File = 0,
+    // one or more images of the same size uploaded as layers of a texture array
+    AssetType_ImageArray,
+} asset_type;
+
+typedef enum asset_state {
+    AssetState_Invalid = 0,
+    AssetState_Loading,
+    AssetState_Ready,
+    AssetState_Failed,
+} asset_state;
+
+typedef struct AssetRef {
+    asset_handle handle;
+} AssetRef;
+
+typedef struct Assets {
+    ECS_DECLARE_COMPONENT(AssetRef);
+} Assets;
+
+asset_handle asset_load_file(const char* path);
+asset_handle asset_load_image_array(const char* const* paths, int32_t count);
+// loads the files of an asset again as a new asset, the old one stays valid until it's released
+asset_handle asset_reload(asset_handle handle);
+asset_state asset_get_state(asset_handle handle);
+// valid once the asset is ready
+const file_view* asset_get_file(asset_handle handle);
+sg_image asset_get_image(asset_handle handle);
+// blocks until the asset has finished loading and completes it, for loads needed right away. Images
+// can still be loading afterwards while the render thread uploads them.
+asset_state asset_wait(asset_handle handle);
+void asset_release(asset_handle handle);
+
+void AssetsImport(ecs_world_t* world);
+
+#define AssetsImportHandles(handles) ECS_IMPORT_COMPONENT(handles, AssetRef);
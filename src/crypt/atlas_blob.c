@@ -0,0 +1,81 @@
+#include "atlas_blob.h"
+#include "futils.h"
+#include "stb_image.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+tx_result atlas_blob_load(const char* filename, struct atlas_blob* blob)
+{
+    TX_ASSERT(blob);
+    memset(blob, 0, sizeof(struct atlas_blob));
+
+    file_view file;
+    tx_result result = file_map(filename, &file);
+
+    if (result != TX_SUCCESS) {
+        return result;
+    }
+
+    const char* data = file.data;
+    const size_t len = file.len;
+
+    struct atlas_blob_header header;
+    if (len < sizeof(header)) {
+        file_unmap(&file);
+        return TX_PARSE_ERROR;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    const size_t sprites_offset = sizeof(header);
+    const size_t pixels_offset = sprites_offset + sizeof(struct atlas_blob_sprite) * header.sprite_count;
+    const size_t expected_pixels =
+        (size_t)header.page_width * header.page_height * header.page_count * 4;
+
+    if (header.magic != ATLAS_BLOB_MAGIC || header.version != ATLAS_BLOB_VERSION ||
+        header.pixels_size != expected_pixels || len < pixels_offset + header.pixels_packed_size) {
+        file_unmap(&file);
+        return TX_PARSE_ERROR;
+    }
+
+    blob->header = header;
+    blob->file = file;
+    blob->sprites = (const struct atlas_blob_sprite*)(data + sprites_offset);
+
+    if (header.compression == AtlasBlobCompression_Zlib) {
+        blob->unpacked_pixels = (uint8_t*)malloc(header.pixels_size);
+        int unpacked = stbi_zlib_decode_buffer(
+            (char*)blob->unpacked_pixels,
+            (int)header.pixels_size,
+            data + pixels_offset,
+            (int)header.pixels_packed_size);
+
+        if (unpacked != (int)header.pixels_size) {
+            atlas_blob_free(blob);
+            return TX_PARSE_ERROR;
+        }
+
+        blob->pixels = blob->unpacked_pixels;
+    } else {
+        blob->pixels = (const uint8_t*)(data + pixels_offset);
+    }
+
+    return TX_SUCCESS;
+}
+
+void atlas_blob_free(struct atlas_blob* blob)
+{
+    free(blob->unpacked_pixels);
+    file_unmap(&blob->file);
+    memset(blob, 0, sizeof(struct atlas_blob));
+}
+
+const struct atlas_blob_sprite* atlas_blob_find(const struct atlas_blob* blob, const char* name)
+{
+    for (uint32_t i = 0; i < blob->header.sprite_count; ++i) {
+        if (strncmp(blob->sprites[i].name, name, ATLAS_BLOB_NAME_MAX) == 0) {
+            return &blob->sprites[i];
+        }
+    }
+    return NULL;
+}
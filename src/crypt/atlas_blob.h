@@ -0,0 +1,61 @@
+// atlas_blob.h - Packed Atlas Blob
+// Binary atlas written by the atlas_packer tool. The blob holds the sprite table followed by the
+// pixels of every page, already decoded to RGBA8 and laid out as texture array layers so the
+// runtime can map it and hand the pixels straight to the gpu.
+//
+// layout:
+//   struct atlas_blob_header
+//   struct atlas_blob_sprite[sprite_count]
+//   pixels: page_count * page_width * page_height * 4 bytes, zlib compressed when
+//           compression == AtlasBlobCompression_Zlib (pixels_packed_size bytes)
+
+#pragma once
+
+#include "futils.h"
+#include "tx_types.h"
+
+enum {
+    ATLAS_BLOB_MAGIC = 0x4c544143, // 'CATL'
+    ATLAS_BLOB_VERSION = 1,
+    ATLAS_BLOB_NAME_MAX = 32,
+};
+
+typedef enum atlas_blob_compression {
+    AtlasBlobCompression_None = 0,
+    AtlasBlobCompression_Zlib = 1,
+} atlas_blob_compression;
+
+struct atlas_blob_header {
+    uint32_t magic;
+    uint32_t version;
+    uint16_t page_width;
+    uint16_t page_height;
+    uint16_t page_count;
+    uint16_t page_tiles; // tiles per page side, sprite_id = page * page_tiles^2 + row * tiles + col
+    uint32_t sprite_count;
+    uint32_t compression;
+    uint32_t pixels_size;
+    uint32_t pixels_packed_size;
+};
+
+struct atlas_blob_sprite {
+    char name[ATLAS_BLOB_NAME_MAX]; // source file name without extension
+    uint16_t sprite_id;
+    uint8_t width;  // in tiles
+    uint8_t height; // in tiles
+    float uv[4];    // x, y, w, h within the page
+};
+
+struct atlas_blob {
+    struct atlas_blob_header header;
+    const struct atlas_blob_sprite* sprites;
+    const uint8_t* pixels;
+    // the sprite table and pixels point straight into the mapped file unless the pixels had to be
+    // decompressed
+    file_view file;
+    uint8_t* unpacked_pixels;
+};
+
+tx_result atlas_blob_load(const char* filename, struct atlas_blob* blob);
+void atlas_blob_free(struct atlas_blob* blob);
+const struct atlas_blob_sprite* atlas_blob_find(const struct atlas_blob* blob, const char* name);
@@ -0,0 +1,101 @@
+#include "curve_blob.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+tx_result curve_blob_parse(const char* data, size_t len, struct curve_blob* blob)
+{
+    TX_ASSERT(blob);
+    memset(blob, 0, sizeof(struct curve_blob));
+
+    struct curve_blob_header header;
+    if (len < sizeof(header)) {
+        return TX_PARSE_ERROR;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    const size_t curves_offset = sizeof(header);
+    const size_t points_offset =
+        curves_offset + sizeof(struct curve_blob_curve) * header.curve_count;
+    const size_t names_offset = points_offset + sizeof(vec2) * header.point_count;
+
+    if (header.magic != CURVE_BLOB_MAGIC || header.version != CURVE_BLOB_VERSION
+        || len < names_offset + header.names_size) {
+        return TX_PARSE_ERROR;
+    }
+
+    const struct curve_blob_curve* curves = (const struct curve_blob_curve*)(data + curves_offset);
+    for (uint32_t i = 0; i < header.curve_count; ++i) {
+        // widened so a huge first_point can't wrap around and pass
+        const uint64_t end = (uint64_t)curves[i].first_point + curves[i].point_count;
+        if (end > header.point_count || curves[i].name_offset >= header.names_size) {
+            return TX_PARSE_ERROR;
+        }
+    }
+
+    // the last name has to be terminated for every name to be safe to use as a string
+    if (header.names_size && data[names_offset + header.names_size - 1] != '\0') {
+        return TX_PARSE_ERROR;
+    }
+
+    blob->header = header;
+    blob->curves = curves;
+    blob->points = (const vec2*)(data + points_offset);
+    blob->names = data + names_offset;
+
+    return TX_SUCCESS;
+}
+
+tx_result curve_blob_write(
+    const char* filename, const struct curve_blob_source* curves, uint32_t curve_count)
+{
+    struct curve_blob_header header = {
+        .magic = CURVE_BLOB_MAGIC,
+        .version = CURVE_BLOB_VERSION,
+        .curve_count = curve_count,
+    };
+
+    struct curve_blob_curve* entries =
+        (struct curve_blob_curve*)calloc(curve_count ? curve_count : 1, sizeof(*entries));
+    for (uint32_t i = 0; i < curve_count; ++i) {
+        entries[i] = (struct curve_blob_curve){
+            .name_offset = header.names_size,
+            .first_point = header.point_count,
+            .point_count = curves[i].point_count,
+        };
+        header.point_count += curves[i].point_count;
+        header.names_size += (uint32_t)strlen(curves[i].name) + 1;
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        free(entries);
+        return TX_FILE_ERROR;
+    }
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(entries, sizeof(*entries), curve_count, file);
+    for (uint32_t i = 0; i < curve_count; ++i) {
+        fwrite(curves[i].points, sizeof(vec2), curves[i].point_count, file);
+    }
+    for (uint32_t i = 0; i < curve_count; ++i) {
+        fwrite(curves[i].name, strlen(curves[i].name) + 1, 1, file);
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    free(entries);
+
+    return (ok) ? TX_SUCCESS : TX_FILE_ERROR;
+}
+
+const char* curve_blob_name(const struct curve_blob* blob, uint32_t curve)
+{
+    return blob->names + blob->curves[curve].name_offset;
+}
+
+const vec2* curve_blob_points(const struct curve_blob* blob, uint32_t curve)
+{
+    return blob->points + blob->curves[curve].first_point;
+}
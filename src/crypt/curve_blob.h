@@ -0,0 +1,57 @@
+// curve_blob.h - Binary Curve Database
+// Compact form of assets/curve_db.json written by the curve editor next to it. Everything is read
+// straight out of the file data, parsing is a header and bounds check. The game streams the file
+// in with the asset loader and parses it once it's ready.
+//
+// layout:
+//   struct curve_blob_header
+//   struct curve_blob_curve[curve_count]
+//   vec2 points[point_count], every curve's points back to back
+//   names: names_size bytes of NUL terminated curve names
+
+#pragma once
+
+#include "tx_math.h"
+#include "tx_types.h"
+
+enum {
+    CURVE_BLOB_MAGIC = 0x56524343, // 'CCRV'
+    CURVE_BLOB_VERSION = 1,
+};
+
+struct curve_blob_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t curve_count;
+    uint32_t point_count;
+    uint32_t names_size;
+};
+
+struct curve_blob_curve {
+    uint32_t name_offset; // into the names table
+    uint32_t first_point;
+    uint32_t point_count;
+};
+
+struct curve_blob {
+    struct curve_blob_header header;
+    // everything below points into the parsed data
+    const struct curve_blob_curve* curves;
+    const vec2* points;
+    const char* names;
+};
+
+// what curve_blob_write packs for each curve
+struct curve_blob_source {
+    const char* name;
+    const vec2* points;
+    uint32_t point_count;
+};
+
+// The blob points into data, which has to outlive it.
+tx_result curve_blob_parse(const char* data, size_t len, struct curve_blob* blob);
+tx_result curve_blob_write(
+    const char* filename, const struct curve_blob_source* curves, uint32_t curve_count);
+
+const char* curve_blob_name(const struct curve_blob* blob, uint32_t curve);
+const vec2* curve_blob_points(const struct curve_blob* blob, uint32_t curve);
@@ -1,27 +1,54 @@
 #include "curves.h"
+#include "assets.h"
+#include "curve_blob.h"
 #include "debug_gui.h"
-#include "parson.h"
+#include "futils.h"
+#include "game_components.h"
+#include "jsstream.h"
 #include "sprite_renderer.h"
 #include "stb_ds.h"
 #include "tx_math.h"
 #include "tx_types.h"
 #include <ccimgui.h>
+#include <stdlib.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CURVE_SIMD 1
+#include <xmmintrin.h>
+#else
+#define CURVE_SIMD 0
+#endif
+
+// Curves are baked into K_CURVE_LUT_SAMPLES points spaced evenly along their length so followers
+// move at a constant speed and evaluating one is a single lerp. Each segment is sampled
+// K_CURVE_BAKE_STEPS times to measure the length.
+enum { K_CURVE_LUT_SAMPLES = 64, K_CURVE_BAKE_STEPS = 16 };
 
 struct curve {
     str_id id;
     vec2* points;
+    // K_CURVE_LUT_SAMPLES points, empty for curves without points
+    vec2* lut;
+    // spline parameter (as passed to curve_eval) of every lut point
+    float* lut_t;
+    float length;
 };
 
 vec2 curve_eval_at(const struct curve* curve, int32_t idx, float t);
 vec2 curve_eval(const struct curve* curve, float t);
+vec2 curve_eval_uniform(const struct curve* curve, float u);
+vec2 curve_eval_distance(const struct curve* curve, float distance);
 void curve_set_points(struct curve* curve, vec2* points, size_t n);
+void curve_bake(struct curve* curve);
+void curve_free(struct curve* curve);
+void curve_db_free(struct curve* db);
 
-JSON_Value* curve_serialize_json(const struct curve* curve);
-void curve_deserialize_json(JSON_Value* json, struct curve* out);
-JSON_Value* curve_db_serialize_json(struct curve* db);
-struct curve* curve_db_deserialize_json(JSON_Value* json);
+void curve_read_json(jsstream* s, struct curve* out);
+struct curve* curve_db_read_json(jsstream* s);
 struct curve* curve_db_load(const char* filename);
+struct curve* curve_db_from_blob(const struct curve_blob* blob);
 void curve_db_save(struct curve* db, const char* filename);
+tx_result curve_db_save_blob(struct curve* db, const char* filename);
 
 void curve_set_points(struct curve* curve, vec2* points, size_t n)
 {
@@ -30,6 +57,79 @@ void curve_set_points(struct curve* curve, vec2* points, size_t n)
     for (size_t i = 0; i < n; ++i) {
         arrput(curve->points, points[i]);
     }
+
+    curve_bake(curve);
+}
+
+void curve_bake(struct curve* curve)
+{
+    const int32_t len = (int32_t)arrlen(curve->points);
+
+    curve->length = 0.0f;
+    if (len == 0) {
+        arrsetlen(curve->lut, 0);
+        arrsetlen(curve->lut_t, 0);
+        return;
+    }
+
+    arrsetlen(curve->lut, K_CURVE_LUT_SAMPLES);
+    arrsetlen(curve->lut_t, K_CURVE_LUT_SAMPLES);
+    if (len == 1) {
+        for (int32_t s = 0; s < K_CURVE_LUT_SAMPLES; ++s) {
+            curve->lut[s] = curve->points[0];
+            curve->lut_t[s] = 0.0f;
+        }
+        return;
+    }
+
+    // dense samples along the spline and the distance travelled up to each of them
+    const int32_t dense_count = (len - 1) * K_CURVE_BAKE_STEPS + 1;
+    vec2* dense = NULL;
+    float* dist = NULL;
+    arrsetlen(dense, dense_count);
+    arrsetlen(dist, dense_count);
+
+    dense[0] = curve->points[0];
+    dist[0] = 0.0f;
+    for (int32_t k = 1; k < dense_count; ++k) {
+        dense[k] = curve_eval(curve, (float)k / K_CURVE_BAKE_STEPS);
+        dist[k] = dist[k - 1] + vec2_len(vec2_sub(dense[k], dense[k - 1]));
+    }
+
+    const float length = dist[dense_count - 1];
+
+    int32_t k = 0;
+    for (int32_t s = 0; s < K_CURVE_LUT_SAMPLES; ++s) {
+        const float target = length * s / (K_CURVE_LUT_SAMPLES - 1);
+        while (k < dense_count - 2 && dist[k + 1] < target) {
+            ++k;
+        }
+
+        const float span = dist[k + 1] - dist[k];
+        const float f = (span > 0.0f) ? clampf01((target - dist[k]) / span) : 0.0f;
+        curve->lut[s] = vec2_lerp(dense[k], dense[k + 1], f);
+        curve->lut_t[s] = (k + f) / K_CURVE_BAKE_STEPS;
+    }
+
+    curve->length = length;
+
+    arrfree(dense);
+    arrfree(dist);
+}
+
+void curve_free(struct curve* curve)
+{
+    arrfree(curve->points);
+    arrfree(curve->lut);
+    arrfree(curve->lut_t);
+}
+
+void curve_db_free(struct curve* db)
+{
+    for (int32_t i = 0; i < arrlen(db); ++i) {
+        curve_free(&db[i]);
+    }
+    arrfree(db);
 }
 
 vec2 curve_eval_at(const struct curve* curve, int32_t idx, float t)
@@ -84,23 +184,239 @@ vec2 curve_eval(const struct curve* curve, float t)
     return curve_eval_at(curve, i, t - i);
 }
 
+// u is the fraction of the curve's length travelled, clamped to [0, 1]. The curve must be baked.
+vec2 curve_eval_uniform(const struct curve* curve, float u)
+{
+    const float f = clampf01(u) * (K_CURVE_LUT_SAMPLES - 1);
+    int32_t i = (int32_t)f;
+    i = (i < K_CURVE_LUT_SAMPLES - 2) ? i : K_CURVE_LUT_SAMPLES - 2;
+    return vec2_lerp(curve->lut[i], curve->lut[i + 1], f - i);
+}
+
+vec2 curve_eval_distance(const struct curve* curve, float distance)
+{
+    return curve_eval_uniform(curve, (curve->length > 0.0f) ? distance / curve->length : 0.0f);
+}
+
+// Spline parameter at a distance along the curve, the curve must be baked.
+float curve_param_at_distance(const struct curve* curve, float distance)
+{
+    const float u = (curve->length > 0.0f) ? distance / curve->length : 0.0f;
+    const float f = clampf01(u) * (K_CURVE_LUT_SAMPLES - 1);
+    int32_t i = (int32_t)f;
+    i = (i < K_CURVE_LUT_SAMPLES - 2) ? i : K_CURVE_LUT_SAMPLES - 2;
+    return lerpf(curve->lut_t[i], curve->lut_t[i + 1], f - i);
+}
+
+// Evaluates count spline parameters of a curve with at least two points. Four parameters go
+// through the Catmull-Rom weights at once, control points are gathered per lane.
+void curve_eval_batch(const struct curve* curve, const float* t, vec2* out, int32_t count)
+{
+    const int32_t len = (int32_t)arrlen(curve->points);
+    const vec2* points = curve->points;
+    const int32_t last_seg = len - 2;
+
+    int32_t i = 0;
+#if CURVE_SIMD
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 five = _mm_set1_ps(5.0f);
+
+    for (; i + 4 <= count; i += 4) {
+        float px[4][4], py[4][4], frac[4];
+        for (int32_t lane = 0; lane < 4; ++lane) {
+            int32_t seg = (int32_t)t[i + lane];
+            seg = (seg < 0) ? 0 : (seg > last_seg) ? last_seg : seg;
+            frac[lane] = t[i + lane] - seg;
+
+            const int32_t idx[4] = {
+                (seg > 0) ? seg - 1 : 0,
+                seg,
+                seg + 1,
+                (seg + 2 < len) ? seg + 2 : len - 1,
+            };
+            for (int32_t p = 0; p < 4; ++p) {
+                px[p][lane] = points[idx[p]].x;
+                py[p][lane] = points[idx[p]].y;
+            }
+        }
+
+        const __m128 f = _mm_loadu_ps(frac);
+        const __m128 f2 = _mm_mul_ps(f, f);
+
+        // same weights as curve_eval_at
+        __m128 w0 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(two, f), f), one);
+        w0 = _mm_mul_ps(_mm_mul_ps(w0, f), half);
+        __m128 w1 = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(three, f), five), f2);
+        w1 = _mm_mul_ps(_mm_add_ps(w1, two), half);
+        __m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(four, _mm_mul_ps(three, f)), f), one);
+        w2 = _mm_mul_ps(_mm_mul_ps(w2, f), half);
+        __m128 w3 = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(f, one), f2), half);
+
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(px[0]), w0);
+        x = _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(px[1]), w1));
+        x = _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(px[2]), w2));
+        x = _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(px[3]), w3));
+
+        __m128 y = _mm_mul_ps(_mm_loadu_ps(py[0]), w0);
+        y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(py[1]), w1));
+        y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(py[2]), w2));
+        y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(py[3]), w3));
+
+        // interleave back into x, y pairs
+        _mm_storeu_ps(&out[i].x, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(&out[i + 2].x, _mm_unpackhi_ps(x, y));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        int32_t seg = (int32_t)t[i];
+        seg = (seg < 0) ? 0 : (seg > last_seg) ? last_seg : seg;
+        out[i] = curve_eval_at(curve, seg, t[i] - seg);
+    }
+}
+
 struct curve* curve_db = NULL;
+asset_handle curve_db_asset = {0};
 struct curve* active_curve = NULL;
 
+// Followers of one curve, collected from every table so they're evaluated together.
+struct curve_follow_bucket {
+    Position** targets;
+    vec2* offsets;
+    float* t;
+    vec2* results;
+};
+
+// one bucket per curve in curve_db, the arrays are kept between frames
+struct curve_follow_bucket* follow_buckets = NULL;
+ecs_query_t* q_curve_followers = NULL;
+
+int32_t curve_db_find(str_id id)
+{
+    for (int32_t i = 0; i < arrlen(curve_db); ++i) {
+        if (str_id_eq(curve_db[i].id, id)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+float advance_follower(CurveFollower* follower, float length, float dt)
+{
+    // single point curves have nowhere to go
+    if (length <= 0.0f) {
+        follower->distance = 0.0f;
+        return 0.0f;
+    }
+
+    follower->distance += follower->speed * dt;
+
+    switch (follower->loop) {
+    case CurveLoop_Repeat:
+        follower->distance = fmodf(follower->distance, length);
+        follower->distance += (follower->distance < 0.0f) ? length : 0.0f;
+        return follower->distance;
+    case CurveLoop_PingPong: {
+        follower->distance = fmodf(follower->distance, length * 2.0f);
+        follower->distance += (follower->distance < 0.0f) ? length * 2.0f : 0.0f;
+        float d = follower->distance;
+        return (d <= length) ? d : length * 2.0f - d;
+    }
+    default:
+        follower->distance = clampf(follower->distance, 0.0f, length);
+        return follower->distance;
+    }
+}
+
+void FollowCurves(ecs_iter_t* it)
+{
+    const int32_t curve_count = (int32_t)arrlen(curve_db);
+    if (curve_count == 0) {
+        return;
+    }
+
+    if (arrlen(follow_buckets) < curve_count) {
+        int32_t prev_len = (int32_t)arrlen(follow_buckets);
+        arrsetlen(follow_buckets, curve_count);
+        memset(
+            &follow_buckets[prev_len],
+            0,
+            sizeof(struct curve_follow_bucket) * (curve_count - prev_len));
+    }
+    for (int32_t c = 0; c < curve_count; ++c) {
+        arrsetlen(follow_buckets[c].targets, 0);
+        arrsetlen(follow_buckets[c].offsets, 0);
+        arrsetlen(follow_buckets[c].t, 0);
+    }
+
+    // followers of a table usually share a curve, only search again when it changes
+    str_id last_id = str_id_invalid;
+    int32_t curve_idx = -1;
+
+    ecs_iter_t qit = ecs_query_iter(q_curve_followers);
+    while (ecs_query_next(&qit)) {
+        CurveFollower* follower = ecs_term(&qit, CurveFollower, 1);
+        Position* pos = ecs_term(&qit, Position, 2);
+
+        for (int32_t i = 0; i < qit.count; ++i) {
+            if (!str_id_eq(follower[i].curve, last_id)) {
+                last_id = follower[i].curve;
+                curve_idx = curve_db_find(last_id);
+            }
+            if (curve_idx < 0 || !arrlen(curve_db[curve_idx].lut)) {
+                continue;
+            }
+
+            const struct curve* curve = &curve_db[curve_idx];
+            float distance = advance_follower(&follower[i], curve->length, it->delta_time);
+
+            if (arrlen(curve->points) < 2) {
+                pos[i] = vec2_add(curve->points[0], follower[i].offset);
+                continue;
+            }
+
+            struct curve_follow_bucket* bucket = &follow_buckets[curve_idx];
+            arrput(bucket->targets, &pos[i]);
+            arrput(bucket->offsets, follower[i].offset);
+            arrput(bucket->t, curve_param_at_distance(curve, distance));
+        }
+    }
+
+    for (int32_t c = 0; c < curve_count; ++c) {
+        struct curve_follow_bucket* bucket = &follow_buckets[c];
+        int32_t count = (int32_t)arrlen(bucket->t);
+        if (count == 0) {
+            continue;
+        }
+
+        arrsetlen(bucket->results, count);
+        curve_eval_batch(&curve_db[c], bucket->t, bucket->results, count);
+
+        for (int32_t i = 0; i < count; ++i) {
+            *bucket->targets[i] = vec2_add(bucket->results[i], bucket->offsets[i]);
+        }
+    }
+}
+
 void TestCurve(ecs_iter_t* it)
 {
-    static float curve_time = 0.0f;
+    static float curve_dist = 0.0f;
+    const float speed = 8.0f;
 
-    if (!active_curve) {
+    if (!active_curve || !arrlen(active_curve->lut)) {
         return;
     }
 
     vec2* points = active_curve->points;
     size_t len = arrlen(points);
 
-    curve_time += it->delta_time;
-    while (curve_time > (float)len) {
-        curve_time -= (float)len;
+    curve_dist += it->delta_time * speed;
+    if (curve_dist > active_curve->length) {
+        curve_dist = 0.0f;
     }
 
     for (size_t i = 0; i < len - 1; ++i) {
@@ -119,17 +435,55 @@ void TestCurve(ecs_iter_t* it)
         }
     }
 
-    vec2 timepos = curve_eval(active_curve, curve_time);
+    vec2 timepos = curve_eval_distance(active_curve, curve_dist);
     vec2 size = (vec2){0.5f, 0.5f};
     vec2 p0 = vec2_sub(timepos, size);
     vec2 p1 = vec2_add(timepos, size);
     draw_rect_col(p0, p1, k_color_azure);
 }
 
+enum { K_CURVE_BENCH_FOLLOWERS = 100000 };
+
 typedef struct curve_debug_gui_context {
-    void* poopy;
+    // milliseconds to evaluate K_CURVE_BENCH_FOLLOWERS points on the active curve
+    float bench_spline_ms;
+    float bench_lut_ms;
+    // sums of the evaluated positions, shown so the benchmark loops can't be optimized out
+    float bench_spline_sum;
+    float bench_lut_sum;
 } curve_debug_gui_context;
 
+// Evaluates the curve once per follower with followers spread evenly along it, the way a frame of
+// curve followers would. Returns the checksum of the positions so the work can't be skipped.
+float curve_bench_spline(const struct curve* curve, float* out_ms)
+{
+    const float t_max = (float)(arrlen(curve->points) - 1);
+    vec2 sum = {0};
+
+    ecs_time_t start = {0};
+    ecs_time_measure(&start);
+    for (int32_t i = 0; i < K_CURVE_BENCH_FOLLOWERS; ++i) {
+        sum = vec2_add(sum, curve_eval(curve, t_max * i / K_CURVE_BENCH_FOLLOWERS));
+    }
+    *out_ms = (float)(ecs_time_measure(&start) * 1000.0);
+
+    return sum.x + sum.y;
+}
+
+float curve_bench_lut(const struct curve* curve, float* out_ms)
+{
+    vec2 sum = {0};
+
+    ecs_time_t start = {0};
+    ecs_time_measure(&start);
+    for (int32_t i = 0; i < K_CURVE_BENCH_FOLLOWERS; ++i) {
+        sum = vec2_add(sum, curve_eval_uniform(curve, (float)i / K_CURVE_BENCH_FOLLOWERS));
+    }
+    *out_ms = (float)(ecs_time_measure(&start) * 1000.0);
+
+    return sum.x + sum.y;
+}
+
 char name_buf[256] = {0};
 
 void curve_debug_gui(ecs_world_t* world, void* ctx)
@@ -138,15 +492,32 @@ void curve_debug_gui(ecs_world_t* world, void* ctx)
 
     if (igButton("Save", (ImVec2){80, 30})) {
         curve_db_save(curve_db, "assets/curve_db.json");
+        if (curve_db_save_blob(curve_db, "assets/curve_db.bin") != TX_SUCCESS) {
+            ecs_os_err("failed to write assets/curve_db.bin");
+        }
     }
     igSameLine(0, -1);
     if (igButton("Load", (ImVec2){80, 30})) {
         active_curve = NULL;
-        if (curve_db) {
-            arrfree(curve_db);
-        }
+        curve_db_free(curve_db);
         curve_db = curve_db_load("assets/curve_db.json");
     }
+    igSameLine(0, -1);
+    if (igButton("Benchmark", (ImVec2){100, 30}) && active_curve
+        && arrlen(active_curve->points) > 1) {
+        context->bench_spline_sum = curve_bench_spline(active_curve, &context->bench_spline_ms);
+        context->bench_lut_sum = curve_bench_lut(active_curve, &context->bench_lut_ms);
+    }
+    igLabelText(
+        "100k evaluations",
+        "spline %0.3fms, baked %0.3fms",
+        context->bench_spline_ms,
+        context->bench_lut_ms);
+    igLabelText(
+        "Checksums",
+        "spline %0.1f, baked %0.1f",
+        context->bench_spline_sum,
+        context->bench_lut_sum);
 
     igSeparator();
 
@@ -196,6 +567,7 @@ void curve_debug_gui(ecs_world_t* world, void* ctx)
 
             igText("Points:");
 
+            bool points_changed = false;
             size_t len = arrlen(active_curve->points);
             for (size_t i = 0; i < len; ++i) {
                 vec2* pt = &active_curve->points[i];
@@ -206,27 +578,79 @@ void curve_debug_gui(ecs_world_t* world, void* ctx)
                 igSeparatorEx(ImGuiSeparatorFlags_Vertical);
                 igSameLine(0, -1);
                 igPushIDInt((int)i + 0xf00d);
-                igInputFloat2("", &pt->x, "%0.2f", ImGuiInputTextFlags_None);
+                points_changed |= igInputFloat2("", &pt->x, "%0.2f", ImGuiInputTextFlags_None);
                 igPopID();
             }
 
             igPushIDStr("Add point");
             if (igButton("+", (ImVec2){30, 30})) {
                 arrput(active_curve->points, ((vec2){0}));
+                points_changed = true;
             }
             igPopID();
+
+            if (points_changed) {
+                curve_bake(active_curve);
+            }
         }
     }
     igEndColumns();
 }
 
+void ResolveCurveDb(ecs_iter_t* it)
+{
+    if (!curve_db_asset.id) {
+        return;
+    }
+
+    asset_state state = asset_get_state(curve_db_asset);
+    if (state == AssetState_Loading) {
+        return;
+    }
+
+    struct curve_blob blob;
+    const file_view* file = asset_get_file(curve_db_asset);
+    if (state == AssetState_Ready && curve_blob_parse(file->data, file->len, &blob) == TX_SUCCESS) {
+        curve_db = curve_db_from_blob(&blob);
+    } else {
+        // the json is the source the blob is written from, it's always there
+        ecs_os_err("failed to load assets/curve_db.bin, falling back to the json");
+        curve_db = curve_db_load("assets/curve_db.json");
+    }
+
+    asset_release(curve_db_asset);
+    curve_db_asset = (asset_handle){0};
+}
+
+void curves_fini(ecs_world_t* world, void* ctx)
+{
+    for (int32_t c = 0; c < arrlen(follow_buckets); ++c) {
+        arrfree(follow_buckets[c].targets);
+        arrfree(follow_buckets[c].offsets);
+        arrfree(follow_buckets[c].t);
+        arrfree(follow_buckets[c].results);
+    }
+    arrfree(follow_buckets);
+
+    active_curve = NULL;
+    curve_db_free(curve_db);
+    curve_db = NULL;
+}
+
 void GameCurvesImport(ecs_world_t* world)
 {
     ECS_MODULE(world, GameCurves);
 
+    ecs_atfini(world, curves_fini, NULL);
+
     ECS_IMPORT(world, DebugGui);
+    ECS_IMPORT(world, GameComp);
+    ECS_IMPORT(world, Assets);
+
+    ECS_COMPONENT(world, CurveFollower);
 
-    curve_db = curve_db_load("assets/curve_db.json");
+    // streamed in while the rest of the world is set up, see ResolveCurveDb
+    curve_db_asset = asset_load_file("assets/curve_db.bin");
 
     DEBUG_PANEL(
         world,
@@ -237,143 +661,181 @@ void GameCurvesImport(ecs_world_t* world)
         curve_debug_gui_context,
         {0});
 
+    ECS_SYSTEM(world, ResolveCurveDb, EcsPostLoad, 0);
     ECS_SYSTEM(world, TestCurve, EcsOnUpdate, : TestCurve);
-}
+    ECS_SYSTEM(world, FollowCurves, EcsOnUpdate, 0);
 
-#include "parson.h"
+    q_curve_followers = ecs_query_new(world, "game.curves.CurveFollower, game.comp.Position");
 
-JSON_Value* curve_serialize_json(const struct curve* curve)
-{
-    JSON_Value* root = json_value_init_object();
-    JSON_Object* obj = json_value_get_object(root);
+    ECS_EXPORT_COMPONENT(CurveFollower);
+}
 
-    const char* name = str_id_cstr(curve->id);
-    if (name) {
-        json_object_set_string(obj, "name", name);
-    } else {
-        json_object_set_string(obj, "name", "default");
-    }
+static jsfield point_fields[] = {
+    JSFIELD(JsField_Float, vec2, x),
+    JSFIELD(JsField_Float, vec2, y),
+};
+static jsobject_desc point_desc = JSOBJECT(point_fields);
 
-    JSON_Array* points_array = json_value_get_array(json_value_init_array());
-    size_t len = arrlen(curve->points);
-    for (size_t i = 0; i < len; ++i) {
-        JSON_Object* point_object = json_value_get_object(json_value_init_object());
-        json_object_set_number(point_object, "x", curve->points[i].x);
-        json_object_set_number(point_object, "y", curve->points[i].y);
-        json_array_append_value(points_array, json_object_get_wrapping_value(point_object));
+// curves look like { "name": "swoop", "points": [{ "x": 0, "y": 0 }, ...] }, the reader is
+// positioned on the curve's JsEvent_ObjectBegin
+void curve_read_json(jsstream* s, struct curve* out)
+{
+    out->id = str_id_empty;
+
+    while (jsstream_next(s) == JsEvent_Key) {
+        const bool is_name = jsstream_eq(s, "name");
+        const bool is_points = jsstream_eq(s, "points");
+
+        jsstream_next(s);
+        if (is_name && s->event == JsEvent_String) {
+            out->id = str_id_store(s->value);
+        } else if (is_points && s->event == JsEvent_ArrayBegin) {
+            while (jsstream_next(s) == JsEvent_ObjectBegin) {
+                vec2 point = {0};
+                jsstream_bind(s, &point_desc, &point);
+                arrput(out->points, point);
+            }
+        }
+        jsstream_skip(s);
     }
 
-    json_object_set_value(obj, "points", json_array_get_wrapping_value(points_array));
-
-    return root;
+    curve_bake(out);
 }
 
-const char* k_curve_json_scheme = "{"
-                                  "\"name\": \"\","
-                                  "\"points\": ["
-                                  "{"
-                                  "\"x\": 0, \"y\": 0"
-                                  "}"
-                                  "]"
-                                  "}";
-
-void curve_deserialize_json(JSON_Value* json, struct curve* out)
+// { "curves": [curve, ...] }
+struct curve* curve_db_read_json(jsstream* s)
 {
-    JSON_Value* schema = json_parse_string(k_curve_json_scheme);
-    if (json != NULL && json_validate(schema, json) == JSONSuccess) {
-        JSON_Object* curve_obj = json_value_get_object(json);
+    struct curve* db = NULL;
 
-        const char* name_str = json_object_get_string(curve_obj, "name");
+    if (jsstream_next(s) != JsEvent_ObjectBegin) {
+        return NULL;
+    }
 
-        if (name_str) {
-            str_id id = str_id_store(name_str);
-            out->id = id;
-        } else {
-            out->id = str_id_empty;
-        }
+    while (jsstream_next(s) == JsEvent_Key) {
+        const bool is_curves = jsstream_eq(s, "curves");
 
-        JSON_Array* points_array = json_object_get_array(curve_obj, "points");
-        if (points_array == NULL) {
-            goto cleanup;
+        jsstream_next(s);
+        if (is_curves && s->event == JsEvent_ArrayBegin) {
+            while (jsstream_next(s) == JsEvent_ObjectBegin) {
+                struct curve curve = {0};
+                curve_read_json(s, &curve);
+                arrput(db, curve);
+            }
         }
+        jsstream_skip(s);
+    }
 
-        vec2* points = NULL;
-        size_t len = json_array_get_count(points_array);
-        for (size_t i = 0; i < len; ++i) {
-            JSON_Object* point_object = json_array_get_object(points_array, i);
-            double x = json_object_get_number(point_object, "x");
-            double y = json_object_get_number(point_object, "y");
-            arrput(points, ((vec2){(float)x, (float)y}));
-        }
-        curve_set_points(out, points, len);
-        arrfree(points);
+    if (s->event == JsEvent_Error) {
+        ecs_os_err("curve db: %s at byte %zu", s->error, s->offset + s->pos);
     }
 
-cleanup:
-    json_value_free(schema);
+    return db;
 }
 
-JSON_Value* curve_db_serialize_json(struct curve* db)
+struct curve* curve_db_load(const char* filename)
 {
-    if (!db) {
+    jsstream* s = malloc(sizeof(jsstream));
+    if (jsstream_open(s, filename) != TX_SUCCESS) {
+        free(s);
         return NULL;
     }
 
-    size_t len = arrlen(db);
-    if (len == 0) {
-        return NULL;
-    }
-
-    JSON_Value* root = json_value_init_object();
-    JSON_Object* db_obj = json_value_get_object(root);
+    struct curve* db = curve_db_read_json(s);
 
-    JSON_Value* curve_node = json_value_init_array();
-    JSON_Array* curve_arr = json_value_get_array(curve_node);
-    for (size_t i = 0; i < len; ++i) {
-        JSON_Value* curve_node = curve_serialize_json(&db[i]);
-        json_array_append_value(curve_arr, curve_node);
-    }
-    json_object_set_value(db_obj, "curves", json_array_get_wrapping_value(curve_arr));
+    jsstream_close(s);
+    free(s);
 
-    return root;
+    return db;
 }
 
-struct curve* curve_db_deserialize_json(JSON_Value* json)
+struct curve* curve_db_from_blob(const struct curve_blob* blob)
 {
     struct curve* db = NULL;
 
-    if (!json) {
-        return NULL;
-    }
-
-    JSON_Object* db_obj = json_value_get_object(json);
-    JSON_Array* curve_arr = json_object_get_array(db_obj, "curves");
-    size_t len = json_array_get_count(curve_arr);
-
+    const uint32_t len = blob->header.curve_count;
     if (len == 0) {
         return NULL;
     }
 
     arrsetlen(db, len);
     memset(db, 0, sizeof(struct curve) * len);
-    for (size_t i = 0; i < len; ++i) {
-        JSON_Value* curve_node =
-            json_object_get_wrapping_value(json_array_get_object(curve_arr, i));
-        curve_deserialize_json(curve_node, &db[i]);
+    for (uint32_t i = 0; i < len; ++i) {
+        db[i].id = str_id_store(curve_blob_name(blob, i));
+
+        // points are copied because the editor changes them, no parsing is needed though
+        const uint32_t point_count = blob->curves[i].point_count;
+        arrsetlen(db[i].points, point_count);
+        memcpy(db[i].points, curve_blob_points(blob, i), sizeof(vec2) * point_count);
+        curve_bake(&db[i]);
     }
 
     return db;
 }
 
-struct curve* curve_db_load(const char* filename)
+tx_result curve_db_save_blob(struct curve* db, const char* filename)
+{
+    const uint32_t len = (uint32_t)arrlen(db);
+
+    struct curve_blob_source* sources = NULL;
+    arrsetlen(sources, len);
+    for (uint32_t i = 0; i < len; ++i) {
+        const char* name = str_id_cstr(db[i].id);
+        sources[i] = (struct curve_blob_source){
+            .name = (name) ? name : "default",
+            .points = db[i].points,
+            .point_count = (uint32_t)arrlen(db[i].points),
+        };
+    }
+
+    tx_result result = curve_blob_write(filename, sources, len);
+    arrfree(sources);
+
+    return result;
+}
+
+static void curve_write_json_string(FILE* file, const char* str)
 {
-    JSON_Value* json = json_parse_file(filename);
-    return curve_db_deserialize_json(json);
+    fputc('"', file);
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*str, file);
+    }
+    fputc('"', file);
 }
 
 void curve_db_save(struct curve* db, const char* filename)
 {
-    JSON_Value* root = curve_db_serialize_json(db);
-    json_serialize_to_file_pretty(root, filename);
-    json_value_free(root);
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        ecs_os_err("failed to write %s", filename);
+        return;
+    }
+
+    const size_t len = arrlen(db);
+    fprintf(file, "{\n    \"curves\": [");
+    for (size_t i = 0; i < len; ++i) {
+        const char* name = str_id_cstr(db[i].id);
+        fprintf(file, "%s\n        {\n", (i > 0) ? "," : "");
+        fprintf(file, "            \"name\": ");
+        curve_write_json_string(file, (name) ? name : "default");
+        fprintf(file, ",\n");
+        fprintf(file, "            \"points\": [");
+
+        const size_t point_count = arrlen(db[i].points);
+        for (size_t p = 0; p < point_count; ++p) {
+            fprintf(
+                file,
+                "%s\n                {\n                    \"x\": %.9g,\n"
+                "                    \"y\": %.9g\n                }",
+                (p > 0) ? "," : "",
+                db[i].points[p].x,
+                db[i].points[p].y);
+        }
+        fprintf(file, "\n            ]\n        }");
+    }
+    fprintf(file, "\n    ]\n}");
+
+    fclose(file);
 }
@@ -1,11 +1,35 @@
 #pragma once
 
 #include "flecs.h"
+#include "str_id.h"
+#include "tx_math.h"
+
+typedef enum curve_loop_mode {
+    // stops at the end of the curve
+    CurveLoop_Once = 0,
+    // jumps back to the start
+    CurveLoop_Repeat = 1,
+    // runs back and forth
+    CurveLoop_PingPong = 2,
+} curve_loop_mode;
+
+// Moves the entity's Position along a curve from the curve db at a constant speed. Positions are
+// in curve space, Position is overwritten every frame so any offset from the curve goes in offset.
+typedef struct CurveFollower {
+    str_id curve;
+    // added to the point on the curve, e.g. to fly a formation along one curve
+    vec2 offset;
+    // world units travelled along the curve
+    float distance;
+    // world units per second
+    float speed;
+    curve_loop_mode loop;
+} CurveFollower;
 
 typedef struct GameCurves {
-    int dummy;
+    ECS_DECLARE_COMPONENT(CurveFollower);
 } GameCurves;
 
 void GameCurvesImport(ecs_world_t* world);
 
-#define GameCurvesImportHandles(handles)
\ No newline at end of file
+#define GameCurvesImportHandles(handles) ECS_IMPORT_COMPONENT(handles, CurveFollower);
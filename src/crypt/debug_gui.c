@@ -1,8 +1,10 @@
 #include "debug_gui.h"
+#include "frame_arena.h"
 #include "game_components.h"
 #include "stb_ds.h"
 #include "system_imgui.h"
 #include <ccimgui.h>
+#include <stdio.h>
 
 struct mem_block {
     void* mem;
@@ -19,6 +21,8 @@ uint8_t* context_mem_head = context_memory;
 
 ecs_world_stats_t world_stats = {0};
 
+static ecs_entity_t debug_label_id = 0;
+
 ImFont* debug_gui_font;
 
 void* store_context(void* ctx, size_t size)
@@ -89,22 +93,6 @@ typedef struct debug_panel_context {
     ECS_DECLARE_COMPONENT(Position);
 } debug_panel_context;
 
-struct plot_marker {
-    float value;
-    ImU32 color;
-};
-
-enum { K_PLOT_DESC_MAX_MARKERS = 16 };
-
-struct gauge_plot_desc {
-    const ecs_gauge_t* gauge;
-    const char* title;
-    ImVec2 size;
-    float vmin;
-    float vmax;
-    struct plot_marker markers[K_PLOT_DESC_MAX_MARKERS];
-};
-
 void plot_ecs_guage(int32_t t, const struct gauge_plot_desc* desc)
 {
     if (!desc) {
@@ -166,6 +154,24 @@ void debug_panel_gui(ecs_world_t* world, void* ctx)
     igLabelText("Entity Count", "%d", ecs_count(world, Position));
     igLabelText("FPS", "%0.0f", stats->fps.max[stats->t]);
 
+    {
+        const frame_arena_stats arena = frame_arena_get_stats();
+        igLabelText(
+            "Frame Arena",
+            "%.1f KB last frame, %.1f KB peak",
+            arena.last_frame_used / 1024.0f,
+            arena.peak / 1024.0f);
+        char overlay[64];
+        snprintf(
+            overlay,
+            sizeof(overlay),
+            "%.0f / %.0f KB, %d spills",
+            arena.peak / 1024.0f,
+            arena.capacity / 1024.0f,
+            arena.spills);
+        igProgressBar((float)arena.peak / arena.capacity, (ImVec2){-1, 0}, overlay);
+    }
+
     if (!context->q_debug_windows) {
         return;
     }
@@ -320,6 +326,20 @@ static void UnloadDebugWindowContext(ecs_iter_t* it)
     }
 }
 
+const char* debug_entity_label(ecs_world_t* world, ecs_entity_t e, char* buf, size_t size)
+{
+    const char* name = ecs_get_name(world, e);
+    const DebugLabel* label = ecs_get_id(world, e, debug_label_id);
+    if (name) {
+        snprintf(buf, size, "%s", name);
+    } else if (label) {
+        snprintf(buf, size, "%s_%03d", label->prefix, label->index);
+    } else {
+        snprintf(buf, size, "#%llu", (unsigned long long)e);
+    }
+    return buf;
+}
+
 void DemoWindow(ecs_iter_t* it)
 {
     igShowDemoWindow(NULL);
@@ -334,6 +354,8 @@ void DebugGuiImport(ecs_world_t* world)
     ecs_set_name_prefix(world, "Debug");
 
     ECS_COMPONENT(world, DebugWindow);
+    ECS_COMPONENT(world, DebugLabel);
+    debug_label_id = ecs_id(DebugLabel);
 
     ECS_SYSTEM(world, StoreDebugWindowContext, EcsOnSet, DebugWindow);
     ECS_SYSTEM(world, UnloadDebugWindowContext, EcsUnSet, DebugWindow);
@@ -356,4 +378,5 @@ void DebugGuiImport(ecs_world_t* world)
         });
 
     ECS_EXPORT_COMPONENT(DebugWindow);
+    ECS_EXPORT_COMPONENT(DebugLabel);
 }
\ No newline at end of file
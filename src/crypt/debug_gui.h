@@ -2,6 +2,7 @@
 
 #include "flecs.h"
 #include "tx_input.h"
+#include <ccimgui.h>
 
 typedef void (*debug_window_fn_t)(ecs_world_t* world, void* ctx);
 
@@ -20,13 +21,46 @@ typedef struct DebugWindow {
     uint32_t flags;
 } DebugWindow;
 
+// Stand-in for EcsName on entities spawned in bulk. It's plain data, so labelling a batch is one
+// more column to copy rather than a name allocated and indexed per entity. The text is only
+// formatted when something asks for it through debug_entity_label.
+typedef struct DebugLabel {
+    const char* prefix; // static string shared by the batch
+    int32_t index;
+} DebugLabel;
+
 typedef struct DebugGui {
     ECS_DECLARE_COMPONENT(DebugWindow);
+    ECS_DECLARE_COMPONENT(DebugLabel);
 } DebugGui;
 
 void DebugGuiImport(ecs_world_t* world);
 
-#define DebugGuiImportHandles(handles) ECS_IMPORT_COMPONENT(handles, DebugWindow);
+struct plot_marker {
+    float value;
+    ImU32 color;
+};
+
+enum { K_PLOT_DESC_MAX_MARKERS = 16 };
+
+struct gauge_plot_desc {
+    const ecs_gauge_t* gauge;
+    const char* title;
+    ImVec2 size;
+    float vmin;
+    float vmax;
+    struct plot_marker markers[K_PLOT_DESC_MAX_MARKERS];
+};
+
+// Plots the averages of a gauge over the last ECS_STAT_WINDOW samples, t is the newest sample.
+void plot_ecs_guage(int32_t t, const struct gauge_plot_desc* desc);
+
+// The entity's name, its DebugLabel as prefix_index or its id, written to buf which is returned.
+const char* debug_entity_label(ecs_world_t* world, ecs_entity_t e, char* buf, size_t size);
+
+#define DebugGuiImportHandles(handles)                                                             \
+    ECS_IMPORT_COMPONENT(handles, DebugWindow);                                                    \
+    ECS_IMPORT_COMPONENT(handles, DebugLabel);
 
 #define DEBUG_PANEL(world, entity, imflags, shortcut, func, ctx_type, ...)                         \
     ECS_ENTITY(world, entity##DebugGui, debug.gui.Window);                                         \
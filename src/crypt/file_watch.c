@@ -0,0 +1,147 @@
+#include "file_watch.h"
+#include "futils.h"
+#include "stb_ds.h"
+
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#define FILE_WATCH_INOTIFY 1
+#else
+#define FILE_WATCH_INOTIFY 0
+#endif
+
+enum { K_WATCH_PATH_MAX = 256, K_POLL_INTERVAL_MS = 250 };
+
+struct watched_file {
+    char path[K_WATCH_PATH_MAX];
+    uint16_t name_offset; // start of the file name in path, after the last separator
+    int wd;           // inotify watch on the containing directory
+    int64_t mtime;
+    bool changed;
+};
+
+struct file_watcher {
+    struct watched_file* files;
+    int inotify_fd;
+    uint32_t last_poll;
+};
+
+static struct file_watcher watcher = {.inotify_fd = -1};
+
+void file_watch_init(void)
+{
+#if FILE_WATCH_INOTIFY
+    watcher.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+void file_watch_term(void)
+{
+#if FILE_WATCH_INOTIFY
+    if (watcher.inotify_fd >= 0) {
+        close(watcher.inotify_fd);
+    }
+#endif
+    arrfree(watcher.files);
+    watcher = (struct file_watcher){.inotify_fd = -1};
+}
+
+int32_t file_watch_add(const char* path)
+{
+    if (strlen(path) >= K_WATCH_PATH_MAX) {
+        return -1;
+    }
+
+    struct watched_file file = {.wd = -1, .mtime = file_mtime(path)};
+    strcpy(file.path, path);
+
+    const char* slash = strrchr(file.path, '/');
+    file.name_offset = (slash) ? (uint16_t)(slash + 1 - file.path) : 0;
+
+#if FILE_WATCH_INOTIFY
+    if (watcher.inotify_fd >= 0) {
+        char dir[K_WATCH_PATH_MAX] = ".";
+        if (slash) {
+            memcpy(dir, file.path, slash - file.path);
+            dir[slash - file.path] = '\0';
+        }
+        // watching the same directory twice returns the existing descriptor
+        file.wd = inotify_add_watch(
+            watcher.inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    }
+#endif
+
+    arrput(watcher.files, file);
+    return (int32_t)arrlen(watcher.files) - 1;
+}
+
+#if FILE_WATCH_INOTIFY
+static void file_watch_drain_inotify(void)
+{
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        ssize_t len = read(watcher.inotify_fd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            break;
+        }
+
+        for (char* ptr = buffer; ptr < buffer + len;) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+
+            for (int32_t i = 0; i < arrlen(watcher.files); ++i) {
+                struct watched_file* file = &watcher.files[i];
+                if (file->wd == event->wd && event->len > 0
+                    && strcmp(file->path + file->name_offset, event->name) == 0) {
+                    file->changed = true;
+                }
+            }
+
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+#endif
+
+void file_watch_update(void)
+{
+#if FILE_WATCH_INOTIFY
+    if (watcher.inotify_fd >= 0) {
+        file_watch_drain_inotify();
+    }
+#endif
+
+    // files without an inotify watch fall back to comparing modification times
+    uint32_t now = SDL_GetTicks();
+    if (now - watcher.last_poll < K_POLL_INTERVAL_MS) {
+        return;
+    }
+    watcher.last_poll = now;
+
+    for (int32_t i = 0; i < arrlen(watcher.files); ++i) {
+        struct watched_file* file = &watcher.files[i];
+        if (file->wd >= 0) {
+            continue;
+        }
+
+        int64_t mtime = file_mtime(file->path);
+        if (mtime != file->mtime) {
+            file->mtime = mtime;
+            file->changed = true;
+        }
+    }
+}
+
+bool file_watch_changed(int32_t id)
+{
+    if (!VALID_INDEX(id, arrlen(watcher.files))) {
+        return false;
+    }
+
+    bool changed = watcher.files[id].changed;
+    watcher.files[id].changed = false;
+    return changed;
+}
@@ -0,0 +1,17 @@
+// file_watch.h - File Change Watching
+// Watches individual files for modification. On Linux the containing directories are watched with
+// inotify (editors often save by replacing the file so the directory is watched rather than the
+// file itself), anywhere else or when inotify is unavailable the file times are polled.
+// Everything runs on the calling thread, file_watch_update drains pending changes.
+
+#pragma once
+
+#include "tx_types.h"
+
+void file_watch_init(void);
+void file_watch_term(void);
+// returns an id for file_watch_changed, -1 if the watch couldn't be added
+int32_t file_watch_add(const char* path);
+void file_watch_update(void);
+// true if the file changed since the last time it was asked about, clears the change
+bool file_watch_changed(int32_t id);
@@ -0,0 +1,151 @@
+#include "frame_arena.h"
+#include "tx_types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct frame_arena_block {
+    struct frame_arena_block* next;
+    size_t size;
+    size_t head;
+    uint8_t* data; // right after the block, K_FRAME_ARENA_MAX_ALIGN aligned
+};
+
+struct frame_arena_buffer {
+    // current block first, any spill blocks in front of the buffer's own block
+    struct frame_arena_block* blocks;
+    size_t used;
+};
+
+static struct {
+    struct frame_arena_buffer buffers[2];
+    int32_t current;
+    size_t capacity;
+    size_t last_frame_used;
+    size_t peak;
+    int32_t spills;
+} arena;
+
+static struct frame_arena_block* frame_arena_block_new(size_t size)
+{
+    struct frame_arena_block* block =
+        malloc(sizeof(struct frame_arena_block) + K_FRAME_ARENA_MAX_ALIGN + size);
+    const uintptr_t align_mask = K_FRAME_ARENA_MAX_ALIGN - 1;
+    *block = (struct frame_arena_block){
+        .size = size,
+        .data = (uint8_t*)(((uintptr_t)(block + 1) + align_mask) & ~align_mask),
+    };
+    return block;
+}
+
+static void frame_arena_buffer_free(struct frame_arena_buffer* buffer)
+{
+    struct frame_arena_block* block = buffer->blocks;
+    while (block) {
+        struct frame_arena_block* next = block->next;
+        free(block);
+        block = next;
+    }
+    *buffer = (struct frame_arena_buffer){0};
+}
+
+static void frame_arena_buffer_reset(struct frame_arena_buffer* buffer)
+{
+    // a spilled buffer is replaced by a single block big enough for it
+    if (!buffer->blocks || buffer->blocks->next || buffer->blocks->size < arena.capacity) {
+        frame_arena_buffer_free(buffer);
+        buffer->blocks = frame_arena_block_new(arena.capacity);
+    }
+    buffer->blocks->head = 0;
+    buffer->used = 0;
+}
+
+void frame_arena_init(size_t capacity)
+{
+    memset(&arena, 0, sizeof(arena));
+    arena.capacity = capacity;
+    frame_arena_buffer_reset(&arena.buffers[0]);
+    frame_arena_buffer_reset(&arena.buffers[1]);
+}
+
+void frame_arena_term(void)
+{
+    frame_arena_buffer_free(&arena.buffers[0]);
+    frame_arena_buffer_free(&arena.buffers[1]);
+}
+
+void frame_arena_next_frame(void)
+{
+    struct frame_arena_buffer* finished = &arena.buffers[arena.current];
+    arena.last_frame_used = finished->used;
+    if (finished->used > arena.peak) {
+        arena.peak = finished->used;
+    }
+    if (finished->blocks && finished->blocks->next) {
+        ++arena.spills;
+        // with some headroom, spilling again next frame would be a waste
+        const size_t grown = arena.peak + arena.peak / 4;
+        arena.capacity = (grown > arena.capacity) ? grown : arena.capacity;
+    }
+
+    arena.current ^= 1;
+    frame_arena_buffer_reset(&arena.buffers[arena.current]);
+}
+
+void* frame_arena_alloc(size_t size, size_t align)
+{
+    TX_ASSERT(align > 0 && align <= K_FRAME_ARENA_MAX_ALIGN && (align & (align - 1)) == 0);
+
+    struct frame_arena_buffer* buffer = &arena.buffers[arena.current];
+    struct frame_arena_block* block = buffer->blocks;
+
+    size_t start = (block->head + align - 1) & ~(align - 1);
+    if (start + size > block->size) {
+        struct frame_arena_block* spill =
+            frame_arena_block_new((size > arena.capacity) ? size : arena.capacity);
+        spill->next = block;
+        buffer->blocks = block = spill;
+        start = 0;
+    }
+
+    buffer->used += start + size - block->head;
+    block->head = start + size;
+    return block->data + start;
+}
+
+frame_arena_stats frame_arena_get_stats(void)
+{
+    return (frame_arena_stats){
+        .capacity = arena.capacity,
+        .frame_used = arena.buffers[arena.current].used,
+        .last_frame_used = arena.last_frame_used,
+        .peak = arena.peak,
+        .spills = arena.spills,
+    };
+}
+
+void* frame_arr_add(frame_arr* arr, size_t size, size_t align)
+{
+    if (arr->count == arr->capacity) {
+        const int32_t capacity = (arr->capacity > 0) ? arr->capacity * 2 : 16;
+        void* items = frame_arena_alloc(size * capacity, align);
+        if (arr->count > 0) {
+            memcpy(items, arr->items, size * arr->count);
+        }
+        arr->items = items;
+        arr->capacity = capacity;
+    }
+    return (uint8_t*)arr->items + size * arr->count++;
+}
+
+void frame_arr_carry(frame_arr* arr, size_t size, size_t align)
+{
+    if (arr->count == 0) {
+        *arr = (frame_arr){0};
+        return;
+    }
+    void* items = frame_arena_alloc(size * arr->count, align);
+    memcpy(items, arr->items, size * arr->count);
+    arr->items = items;
+    arr->capacity = arr->count;
+}
@@ -0,0 +1,69 @@
+// frame_arena.h - Frame Arena
+// Linear allocator for scratch data that only lives for a frame. Allocating bumps a pointer and
+// nothing is freed individually. The arena has two buffers, frame_arena_next_frame resets the
+// older one and makes it current, so whatever was allocated during the previous frame is still
+// readable for one more frame (e.g. events queued after they were processed).
+//
+// A frame that doesn't fit spills into extra blocks, the buffer is regrown to the largest frame
+// seen when it's reset so the spill only happens once. Main thread only.
+//
+// Arrays whose length isn't known up front use frame_arr. Growing one copies it into a block twice
+// the size and abandons the old one, it's reclaimed with the rest of the frame.
+//
+// The renderer's instance and primitive arrays stay on stb_ds. The render thread draws a packet
+// while the next frame is simulated, which the arena's two frames would just about cover, but the
+// arrays are cleared and reused every frame and don't allocate once grown, and the frame mailbox
+// swaps them between packets, which only works with arrays that own their memory.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum { K_FRAME_ARENA_DEFAULT_SIZE = 256 * 1024, K_FRAME_ARENA_MAX_ALIGN = 16 };
+
+#if defined(_MSC_VER)
+#define FRAME_ALIGNOF(type) __alignof(type)
+#else
+#define FRAME_ALIGNOF(type) __alignof__(type)
+#endif
+
+// capacity is per buffer
+void frame_arena_init(size_t capacity);
+void frame_arena_term(void);
+// Called once per ecs_progress, everything allocated two frames ago is gone afterwards.
+void frame_arena_next_frame(void);
+void* frame_arena_alloc(size_t size, size_t align);
+
+#define frame_push(type) ((type*)frame_arena_alloc(sizeof(type), FRAME_ALIGNOF(type)))
+#define frame_push_n(type, count)                                                                  \
+    ((type*)frame_arena_alloc(sizeof(type) * (count), FRAME_ALIGNOF(type)))
+
+typedef struct frame_arena_stats {
+    size_t capacity;
+    // bytes taken so far this frame, padding and abandoned array blocks included
+    size_t frame_used;
+    size_t last_frame_used;
+    // most bytes a single frame has used
+    size_t peak;
+    // frames that didn't fit in the buffer
+    int32_t spills;
+} frame_arena_stats;
+
+frame_arena_stats frame_arena_get_stats(void);
+
+// Growable array in the arena. Start from {0} every frame, or carry it into the new frame first
+// when it has to outlive the previous one.
+typedef struct frame_arr {
+    void* items;
+    int32_t count;
+    int32_t capacity;
+} frame_arr;
+
+void* frame_arr_add(frame_arr* arr, size_t size, size_t align);
+// Copies the items into the current frame so they survive the next reset.
+void frame_arr_carry(frame_arr* arr, size_t size, size_t align);
+
+#define frame_arr_push(arr, type, value)                                                           \
+    (*(type*)frame_arr_add(&(arr), sizeof(type), FRAME_ALIGNOF(type)) = (value))
+#define frame_arr_items(arr, type) ((type*)(arr).items)
@@ -1,48 +1,178 @@
 #include "futils.h"
 
-#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 
-enum tx_result read_file_to_buffer(const char* filename, char** buffer, size_t* len)
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static const char k_empty_file[1] = {'\0'};
+
+#if defined(_WIN32)
+
+enum tx_result file_map(const char* filename, file_view* view)
 {
-    if (!(buffer && len)) {
+    if (!(filename && view)) {
         return TX_INVALID_PARAMTER;
     }
 
-    enum tx_result result = TX_INVALID;
-    size_t string_size = 0, read_size = 0;
-    FILE* file = fopen(filename, "r");
+    memset(view, 0, sizeof(file_view));
 
-    if (file) {
-        fseek(file, 0, SEEK_END);
-        long tell = ftell(file);
+    HANDLE file = CreateFileA(
+        filename,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        NULL);
 
-        if (tell < 0) {
-            result = TX_FILE_ERROR;
-            goto exit;
-        }
+    if (file == INVALID_HANDLE_VALUE) {
+        return TX_FILE_ERROR;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return TX_FILE_ERROR;
+    }
+
+    view->len = (size_t)size.QuadPart;
+
+    if (view->len == 0) {
+        CloseHandle(file);
+        view->data = k_empty_file;
+        return TX_SUCCESS;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    // the mapping keeps its own reference to the file
+    CloseHandle(file);
 
-        string_size = (size_t)tell;
+    if (!mapping) {
+        return TX_FILE_ERROR;
+    }
 
-        rewind(file);
-        char* mem = (char*)malloc(string_size + 1);
-        if (mem == NULL) {
-            result = TX_ALLOCATION_ERROR;
-            goto exit;
+    void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!base) {
+        CloseHandle(mapping);
+        return TX_FILE_ERROR;
+    }
+
+    view->data = (const char*)base;
+    view->_map_base = base;
+    view->_map_handle = mapping;
+
+    // The tail of the last page past the end of the file reads as zero which terminates the view.
+    // Files that end exactly on a page boundary have no tail so those get copied instead.
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    if (view->len % info.dwPageSize == 0) {
+        view->_copy = (char*)malloc(view->len + 1);
+        if (!view->_copy) {
+            file_unmap(view);
+            return TX_ALLOCATION_ERROR;
         }
+        memcpy(view->_copy, base, view->len);
+        view->_copy[view->len] = '\0';
+        view->data = view->_copy;
+    }
 
-        read_size = fread(mem, sizeof(char), string_size, file);
-        mem[read_size] = '\0';
+    return TX_SUCCESS;
+}
 
-        *buffer = mem;
-        *len = read_size;
+void file_unmap(file_view* view)
+{
+    if (view->_map_base) {
+        UnmapViewOfFile(view->_map_base);
+    }
+    if (view->_map_handle) {
+        CloseHandle((HANDLE)view->_map_handle);
+    }
+    free(view->_copy);
+    memset(view, 0, sizeof(file_view));
+}
+
+#else
 
+enum tx_result file_map(const char* filename, file_view* view)
+{
+    if (!(filename && view)) {
+        return TX_INVALID_PARAMTER;
+    }
+
+    memset(view, 0, sizeof(file_view));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return TX_FILE_ERROR;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return TX_FILE_ERROR;
+    }
+
+    view->len = (size_t)st.st_size;
+
+    if (view->len == 0) {
+        close(fd);
+        view->data = k_empty_file;
         return TX_SUCCESS;
-    } else {
+    }
+
+    // Reserve one byte more than the file as anonymous (zeroed) memory and map the file over the
+    // front of it, the byte after the file is then always a readable NUL even when the file ends
+    // on a page boundary.
+    size_t map_len = view->len + 1;
+    void* base = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return TX_ALLOCATION_ERROR;
+    }
+
+    void* mapped = mmap(base, view->len, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if (mapped == MAP_FAILED) {
+        munmap(base, map_len);
         return TX_FILE_ERROR;
     }
 
-exit:
-    fclose(file);
-    return result;
+    madvise(base, view->len, MADV_WILLNEED);
+
+    view->data = (const char*)base;
+    view->_map_base = base;
+    view->_map_len = map_len;
+
+    return TX_SUCCESS;
+}
+
+void file_unmap(file_view* view)
+{
+    if (view->_map_base) {
+        munmap(view->_map_base, view->_map_len);
+    }
+    free(view->_copy);
+    memset(view, 0, sizeof(file_view));
+}
+
+#endif
+
+int64_t file_mtime(const char* filename)
+{
+    struct stat st;
+    if (stat(filename, &st) != 0) {
+        return 0;
+    }
+    return (int64_t)st.st_mtime;
 }
@@ -5,4 +5,20 @@
 
 #include "tx_types.h"
 
-enum tx_result read_file_to_buffer(const char* filename, char** buffer, size_t* len);
+// Read-only view of a whole file mapped into memory. data is always followed by a NUL byte so
+// text consumers can use it as a string, len doesn't include it.
+typedef struct file_view {
+    const char* data;
+    size_t len;
+    // platform specific mapping state
+    void* _map_base;
+    size_t _map_len;
+    void* _map_handle;
+    char* _copy;
+} file_view;
+
+enum tx_result file_map(const char* filename, file_view* view);
+void file_unmap(file_view* view);
+
+// Last modification time of the file in seconds, 0 if it doesn't exist.
+int64_t file_mtime(const char* filename);
@@ -1,4 +1,5 @@
 #include "game_components.h"
+#include "scene.h"
 
 void GameCompImport(ecs_world_t* world)
 {
@@ -9,6 +10,10 @@ void GameCompImport(ecs_world_t* world)
     ECS_COMPONENT(world, Velocity);
     ECS_TAG(world, Highlight);
 
+    SCENE_COMPONENT(world, Position, &scene_vec2_desc);
+    SCENE_COMPONENT(world, LocalPosition, &scene_vec2_desc);
+    SCENE_COMPONENT(world, Velocity, &scene_vec2_desc);
+
     ECS_EXPORT_COMPONENT(Position);
     ECS_EXPORT_COMPONENT(LocalPosition);
     ECS_EXPORT_COMPONENT(Velocity);
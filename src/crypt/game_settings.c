@@ -1,11 +1,29 @@
 #include "game_settings.h"
 
-#include "futils.h"
-#include "jsonutil.h"
-#include "stb_ds.h"
+#include "jsstream.h"
+
+#include <stdlib.h>
 
 game_settings settings = {0};
 
+static jsfield video_fields[] = {
+    JSFIELD(JsField_Int, game_video_options, display_width),
+    JSFIELD(JsField_Int, game_video_options, display_height),
+    JSFIELD(JsField_Bool, game_video_options, enable_vsync),
+    JSFIELD(JsField_Int, game_video_options, frame_limit),
+};
+static jsobject_desc video_desc = JSOBJECT(video_fields);
+
+static jsfield options_fields[] = {
+    JSFIELD_OBJECT(game_options, video, &video_desc),
+};
+static jsobject_desc options_desc = JSOBJECT(options_fields);
+
+static jsfield settings_fields[] = {
+    JSFIELD_OBJECT(game_settings, options, &options_desc),
+};
+static jsobject_desc settings_desc = JSOBJECT(settings_fields);
+
 game_settings* const get_game_settings()
 {
     return &settings;
@@ -18,43 +36,20 @@ bool load_game_settings(const char* file_override)
         filename = (char*)file_override;
     }
 
-    char* js;
-    size_t len;
-    tx_result result = read_file_to_buffer(filename, &js, &len);
+    jsstream* s = malloc(sizeof(jsstream));
+    tx_result result = jsstream_open(s, filename);
 
     if (result != TX_SUCCESS) {
+        free(s);
         return result;
     }
 
-    jsmn_parser parser;
-    jsmn_init(&parser);
-
-    int tok_needed = jsmn_parse(&parser, js, len, NULL, 0);
-    jsmntok_t* tokens = NULL;
-    arrsetlen(tokens, tok_needed);
-
-    jsmn_init(&parser);
-    int tok_len = jsmn_parse(&parser, js, len, tokens, tok_needed);
-
-    int opt_id = jsget_id(js, tokens, 0, "options");
-    {
-        int video_opt_id = jsget_id(js, tokens, opt_id, "video");
-        {
-            settings.options.video.display_width =
-                jstoi_or(js, jsget(js, tokens, video_opt_id, "display_width"), 0);
-
-            settings.options.video.display_height =
-                jstoi_or(js, jsget(js, tokens, video_opt_id, "display_height"), 0);
-
-            settings.options.video.enable_vsync =
-                jstob_or(js, jsget(js, tokens, video_opt_id, "enable_vsync"), false);
-
-            settings.options.video.frame_limit =
-                jstoi_or(js, jsget(js, tokens, video_opt_id, "frame_limit"), 0);
-        }
+    if (jsstream_next(s) == JsEvent_ObjectBegin) {
+        jsstream_bind(s, &settings_desc, &settings);
     }
 
-    arrfree(tokens);
+    jsstream_close(s);
+    free(s);
 
     return TX_SUCCESS;
 }
\ No newline at end of file
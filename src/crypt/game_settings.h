@@ -2,15 +2,19 @@
 
 #include "tx_types.h"
 
+typedef struct game_video_options {
+    int display_width;
+    int display_height;
+    bool enable_vsync;
+    int frame_limit;
+} game_video_options;
+
+typedef struct game_options {
+    game_video_options video;
+} game_options;
+
 typedef struct game_settings {
-    struct {
-        struct {
-            int display_width;
-            int display_height;
-            bool enable_vsync;
-            int frame_limit;
-        } video;
-    } options;
+    game_options options;
 } game_settings;
 
 game_settings* const get_game_settings();
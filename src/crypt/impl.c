@@ -3,7 +3,19 @@
 #include <GL/gl3w.h>
 
 #define SOKOL_IMPL
+#if CRYPT_HEADLESS
+#define SOKOL_DUMMY_BACKEND
+#else
 #define SOKOL_GLCORE33
+// lets shader_cache build sokol's programs from saved program binaries, see shader_binary.h
+#include "shader_binary.h"
+#undef glCompileShader
+#define glCompileShader shader_binary_compile_shader
+#undef glGetShaderiv
+#define glGetShaderiv shader_binary_get_shaderiv
+#undef glLinkProgram
+#define glLinkProgram shader_binary_link_program
+#endif
 #define SOKOL_ASSERT
 #include "sokol_gfx.h"
 
@@ -0,0 +1,122 @@
+#include "jobs.h"
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+struct job_pool {
+    SDL_Thread* workers[JOBS_MAX_WORKERS];
+    int32_t num_workers;
+    SDL_sem* work_sem;
+    SDL_sem* done_sem;
+    SDL_atomic_t quit;
+
+    // current batch, only written by jobs_run while every worker is parked on work_sem
+    job_fn_t fn;
+    void* ctx;
+    int32_t job_count;
+    SDL_atomic_t next_job;
+};
+
+static struct job_pool pool = {0};
+
+static void jobs_drain(void)
+{
+    for (;;) {
+        int32_t job = SDL_AtomicAdd(&pool.next_job, 1);
+        if (job >= pool.job_count) {
+            break;
+        }
+        pool.fn(pool.ctx, job);
+    }
+}
+
+static int jobs_worker_main(void* data)
+{
+    for (;;) {
+        SDL_SemWait(pool.work_sem);
+
+        if (SDL_AtomicGet(&pool.quit)) {
+            break;
+        }
+
+        jobs_drain();
+        SDL_SemPost(pool.done_sem);
+    }
+
+    return 0;
+}
+
+void jobs_init(int32_t num_workers)
+{
+    TX_ASSERT(pool.num_workers == 0);
+
+    if (num_workers > JOBS_MAX_WORKERS) {
+        num_workers = JOBS_MAX_WORKERS;
+    }
+
+    pool.work_sem = SDL_CreateSemaphore(0);
+    pool.done_sem = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&pool.quit, 0);
+
+    for (int32_t i = 0; i < num_workers; ++i) {
+        char name[16];
+        snprintf(name, 16, "job_worker_%02d", i);
+        pool.workers[i] = SDL_CreateThread(jobs_worker_main, name, NULL);
+        if (!pool.workers[i]) {
+            break;
+        }
+        pool.num_workers++;
+    }
+}
+
+void jobs_term(void)
+{
+    SDL_AtomicSet(&pool.quit, 1);
+
+    for (int32_t i = 0; i < pool.num_workers; ++i) {
+        SDL_SemPost(pool.work_sem);
+    }
+
+    for (int32_t i = 0; i < pool.num_workers; ++i) {
+        SDL_WaitThread(pool.workers[i], NULL);
+    }
+
+    if (pool.work_sem) SDL_DestroySemaphore(pool.work_sem);
+    if (pool.done_sem) SDL_DestroySemaphore(pool.done_sem);
+
+    memset(&pool, 0, sizeof(struct job_pool));
+}
+
+int32_t jobs_worker_count(void)
+{
+    return pool.num_workers;
+}
+
+void jobs_run(job_fn_t fn, void* ctx, int32_t job_count)
+{
+    if (!fn || job_count <= 0) {
+        return;
+    }
+
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.job_count = job_count;
+    SDL_AtomicSet(&pool.next_job, 0);
+
+    // single jobs aren't worth waking anybody up for
+    int32_t wake = (job_count > 1) ? pool.num_workers : 0;
+    if (wake > job_count - 1) {
+        wake = job_count - 1;
+    }
+
+    for (int32_t i = 0; i < wake; ++i) {
+        SDL_SemPost(pool.work_sem);
+    }
+
+    jobs_drain();
+
+    for (int32_t i = 0; i < wake; ++i) {
+        SDL_SemWait(pool.done_sem);
+    }
+}
@@ -0,0 +1,16 @@
+// jobs.h - Job Pool
+// small fixed worker pool for splitting data parallel work (e.g. sprite gathering) across cores.
+// jobs_run blocks until every job has finished, the calling thread works on jobs while it waits.
+
+#pragma once
+
+#include "tx_types.h"
+
+enum { JOBS_MAX_WORKERS = 15 };
+
+typedef void (*job_fn_t)(void* ctx, int32_t job_index);
+
+void jobs_init(int32_t num_workers);
+void jobs_term(void);
+int32_t jobs_worker_count(void);
+void jobs_run(job_fn_t fn, void* ctx, int32_t job_count);
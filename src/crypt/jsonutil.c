@@ -1,4 +1,5 @@
 #include "jsonutil.h"
+#include "hash.h"
 
 bool jseq(const char* js, jsmntok_t token, const char* str)
 {
@@ -126,12 +127,154 @@ int jsget_id(const char* js, jsmntok_t* tokens, int parent_id, const char* key)
         return -1;
     }
 
-    int next = jsnextsib(tokens, parent_id);
-    for (int i = parent_id + 1; i < next; i = jsnextsib(tokens, i)) {
-        if (jseq(js, tokens[i], key)) {
-            return i + 1;
+    int key_id = parent_id + 1;
+    for (int k = 0; k < tokens[parent_id].size; ++k) {
+        if (jseq(js, tokens[key_id], key)) {
+            return key_id + 1;
         }
+        key_id = jsskip(tokens, key_id);
     }
 
     return -1;
 }
+
+int jsparse(const char* js, size_t len, jsmntok_t** tokens)
+{
+    jsmn_parser parser;
+    jsmn_init(&parser);
+
+    // roughly one token per 8 bytes of json, jsmn picks up where it stopped when it needs more
+    size_t cap = arrcap(*tokens);
+    if (cap < len / 8 + 16) {
+        cap = len / 8 + 16;
+    }
+    arrsetlen(*tokens, cap);
+
+    int result;
+    while ((result = jsmn_parse(&parser, js, len, *tokens, (unsigned int)arrlen(*tokens))) ==
+           JSMN_ERROR_NOMEM) {
+        arrsetlen(*tokens, arrlen(*tokens) * 2);
+    }
+
+    arrsetlen(*tokens, (result > 0) ? result : 0);
+    return result;
+}
+
+int jsskip(const jsmntok_t* tokens, int tok_id)
+{
+    // every token is followed by `size` direct children (keys have their value as their child)
+    int pending = 1;
+    while (pending > 0) {
+        pending += tokens[tok_id].size - 1;
+        ++tok_id;
+    }
+    return tok_id;
+}
+
+void jsfield_set_int(const jsfield* field, void* member, int64_t value)
+{
+    switch (field->size) {
+    case 1:
+        *(int8_t*)member = (int8_t)value;
+        break;
+    case 2:
+        *(int16_t*)member = (int16_t)value;
+        break;
+    case 8:
+        *(int64_t*)member = value;
+        break;
+    default:
+        *(int32_t*)member = (int32_t)value;
+        break;
+    }
+}
+
+static void jsbind_value(const char* js, const jsmntok_t* tokens, int val_id, jsfield* field,
+    uint8_t* member)
+{
+    const jsmntok_t token = tokens[val_id];
+
+    switch (field->type) {
+    case JsField_Int: {
+        double value;
+        if (jstod(js, token, &value)) {
+            jsfield_set_int(field, member, (int64_t)value);
+        }
+    } break;
+    case JsField_Float: {
+        float value;
+        if (jstof(js, token, &value)) {
+            *(float*)member = value;
+        }
+    } break;
+    case JsField_Bool: {
+        bool value;
+        if (jstob(js, token, &value)) {
+            *(bool*)member = value;
+        }
+    } break;
+    case JsField_String:
+        if (token.type == JSMN_STRING && field->size > 0) {
+            size_t len = (size_t)(token.end - token.start);
+            len = (len < field->size - 1) ? len : field->size - 1;
+            memcpy(member, js + token.start, len);
+            member[len] = '\0';
+        }
+        break;
+    case JsField_Object:
+        jsbind(js, tokens, val_id, field->object, member);
+        break;
+    case JsField_Enum:
+        for (int e = 0; e < field->enum_count; ++e) {
+            if (jseq(js, token, field->enum_names[e])) {
+                *(int*)member = e;
+                break;
+            }
+        }
+        break;
+    case JsField_Token:
+        *(int*)member = val_id;
+        break;
+    }
+}
+
+jsfield* jsobject_find(jsobject_desc* desc, const char* key, size_t len)
+{
+    if (!desc->hashed) {
+        for (int f = 0; f < desc->count; ++f) {
+            desc->fields[f].hash = hash_string(desc->fields[f].name);
+        }
+        desc->hashed = true;
+    }
+
+    const uint32_t key_hash = hash_data(key, len);
+    for (int f = 0; f < desc->count; ++f) {
+        jsfield* field = &desc->fields[f];
+        if (field->hash == key_hash && strlen(field->name) == len
+            && strncmp(field->name, key, len) == 0) {
+            return field;
+        }
+    }
+
+    return NULL;
+}
+
+int jsbind(const char* js, const jsmntok_t* tokens, int obj_id, jsobject_desc* desc, void* out)
+{
+    if (obj_id < 0 || tokens[obj_id].type != JSMN_OBJECT) {
+        return -1;
+    }
+
+    int key_id = obj_id + 1;
+    for (int k = 0; k < tokens[obj_id].size; ++k) {
+        const jsmntok_t key = tokens[key_id];
+        jsfield* field = jsobject_find(desc, js + key.start, (size_t)(key.end - key.start));
+        if (field) {
+            jsbind_value(js, tokens, key_id + 1, field, (uint8_t*)out + field->offset);
+        }
+
+        key_id = jsskip(tokens, key_id + 1);
+    }
+
+    return key_id;
+}
@@ -5,6 +5,7 @@
 #include "jsmn.h"
 
 #include "tx_types.h"
+#include <stddef.h>
 
 bool jseq(const char* js, jsmntok_t token, const char* str);
 bool jsstrncpy(const char* js, jsmntok_t token, char* buffer, size_t len);
@@ -20,3 +21,88 @@ bool jstob_or(const char* js, jsmntok_t token, bool def);
 int jsnextsib(jsmntok_t* tokens, int tok_id);
 jsmntok_t jsget(const char* js, jsmntok_t* tokens, int parent_id, const char* key);
 int jsget_id(const char* js, jsmntok_t* tokens, int parent_id, const char* key);
+
+// Parses js into tokens (an stb_ds array that can be reused between files) in a single pass,
+// growing it whenever jsmn runs out of room. Returns the token count or a negative jsmnerr.
+int jsparse(const char* js, size_t len, jsmntok_t** tokens);
+// Index of the first token after the value at tok_id and everything nested in it.
+int jsskip(const jsmntok_t* tokens, int tok_id);
+
+// Data binding, a table of field descriptors maps object keys straight onto struct members:
+//
+//   static jsfield video_fields[] = {
+//       JSFIELD(JsField_Int, video_options, display_width),
+//       JSFIELD(JsField_Bool, video_options, enable_vsync),
+//   };
+//   static jsobject_desc video_desc = JSOBJECT(video_fields);
+//   jsbind(js, tokens, obj_id, &video_desc, &video);
+//
+// Keys are matched against hashes computed once per descriptor, members without a key in the
+// object keep whatever value they had so defaults can be filled in before binding.
+typedef enum jsfield_type {
+    // any 1, 2, 4 or 8 byte integer member, jsfield.size picks the width
+    JsField_Int,
+    JsField_Float,
+    JsField_Bool,
+    // fixed size char array, always NUL terminated and truncated to fit
+    JsField_String,
+    // nested object bound with jsfield.object
+    JsField_Object,
+    // string matched against jsfield.enum_names, stored as an int index
+    JsField_Enum,
+    // int index of the value token, for anything that needs custom handling
+    JsField_Token,
+} jsfield_type;
+
+typedef struct jsobject_desc jsobject_desc;
+
+typedef struct jsfield {
+    const char* name;
+    jsfield_type type;
+    size_t offset;
+    size_t size;
+    jsobject_desc* object;
+    const char* const* enum_names;
+    int enum_count;
+    uint32_t hash;
+} jsfield;
+
+struct jsobject_desc {
+    jsfield* fields;
+    int count;
+    bool hashed;
+};
+
+#define JSFIELD(field_type, struct_type, member)                                                   \
+    {                                                                                              \
+        .name = #member, .type = field_type, .offset = offsetof(struct_type, member),             \
+        .size = sizeof(((struct_type*)0)->member)                                                  \
+    }
+
+#define JSFIELD_OBJECT(struct_type, member, desc)                                                  \
+    {                                                                                              \
+        .name = #member, .type = JsField_Object, .offset = offsetof(struct_type, member),         \
+        .size = sizeof(((struct_type*)0)->member), .object = desc                                  \
+    }
+
+#define JSFIELD_ENUM(struct_type, member, names)                                                   \
+    {                                                                                              \
+        .name = #member, .type = JsField_Enum, .offset = offsetof(struct_type, member),           \
+        .size = sizeof(((struct_type*)0)->member), .enum_names = names,                            \
+        .enum_count = sizeof(names) / sizeof(names[0])                                             \
+    }
+
+#define JSOBJECT(field_array)                                                                      \
+    {                                                                                              \
+        .fields = field_array, .count = sizeof(field_array) / sizeof(field_array[0])               \
+    }
+
+// Stores value into an integer member of field->size bytes.
+void jsfield_set_int(const jsfield* field, void* member, int64_t value);
+
+// Field of desc named by the len bytes at key or NULL, hashes the field names on first use.
+jsfield* jsobject_find(jsobject_desc* desc, const char* key, size_t len);
+
+// Binds the object at obj_id onto out in one pass over its tokens, unknown keys are skipped.
+// Returns the index of the token after the object or -1 if obj_id isn't an object.
+int jsbind(const char* js, const jsmntok_t* tokens, int obj_id, jsobject_desc* desc, void* out);
@@ -0,0 +1,379 @@
+#include "jsstream.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+tx_result jsstream_open(jsstream* s, const char* filename)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return TX_FILE_ERROR;
+    }
+
+    jsstream_init(s, NULL, 0);
+    s->file = file;
+    s->buf = s->chunk;
+
+    return TX_SUCCESS;
+}
+
+void jsstream_init(jsstream* s, const char* js, size_t len)
+{
+    s->event = JsEvent_End;
+    s->value[0] = '\0';
+    s->value_len = 0;
+    s->truncated = false;
+    s->number = 0.0;
+    s->boolean = false;
+    s->error = NULL;
+    s->offset = 0;
+    s->buf = js;
+    s->len = len;
+    s->pos = 0;
+    s->file = NULL;
+    s->depth = 0;
+    s->want_key = false;
+}
+
+void jsstream_close(jsstream* s)
+{
+    if (s->file) {
+        fclose(s->file);
+        s->file = NULL;
+    }
+}
+
+static bool jsstream_fill(jsstream* s)
+{
+    if (!s->file) {
+        return false;
+    }
+
+    s->offset += s->len;
+    s->len = fread(s->chunk, 1, K_JSSTREAM_CHUNK_SIZE, s->file);
+    s->pos = 0;
+
+    return s->len > 0;
+}
+
+// next byte without consuming it, -1 at the end of the input
+static inline int jsstream_peek(jsstream* s)
+{
+    if (s->pos == s->len && !jsstream_fill(s)) {
+        return -1;
+    }
+    return (unsigned char)s->buf[s->pos];
+}
+
+static inline int jsstream_getc(jsstream* s)
+{
+    const int c = jsstream_peek(s);
+    s->pos += (c >= 0);
+    return c;
+}
+
+static inline void jsstream_putc(jsstream* s, char c)
+{
+    if (s->value_len < K_JSSTREAM_MAX_VALUE - 1) {
+        s->value[s->value_len++] = c;
+    } else {
+        s->truncated = true;
+    }
+}
+
+static jsevent jsstream_fail(jsstream* s, const char* error)
+{
+    s->error = error;
+    s->event = JsEvent_Error;
+    return JsEvent_Error;
+}
+
+static void jsstream_put_utf8(jsstream* s, uint32_t cp)
+{
+    if (cp < 0x80) {
+        jsstream_putc(s, (char)cp);
+    } else if (cp < 0x800) {
+        jsstream_putc(s, (char)(0xc0 | (cp >> 6)));
+        jsstream_putc(s, (char)(0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+        jsstream_putc(s, (char)(0xe0 | (cp >> 12)));
+        jsstream_putc(s, (char)(0x80 | ((cp >> 6) & 0x3f)));
+        jsstream_putc(s, (char)(0x80 | (cp & 0x3f)));
+    } else {
+        jsstream_putc(s, (char)(0xf0 | (cp >> 18)));
+        jsstream_putc(s, (char)(0x80 | ((cp >> 12) & 0x3f)));
+        jsstream_putc(s, (char)(0x80 | ((cp >> 6) & 0x3f)));
+        jsstream_putc(s, (char)(0x80 | (cp & 0x3f)));
+    }
+}
+
+static bool jsstream_read_hex4(jsstream* s, uint32_t* out)
+{
+    uint32_t cp = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int c = jsstream_getc(s);
+        cp <<= 4;
+        if (c >= '0' && c <= '9') {
+            cp |= (uint32_t)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            cp |= (uint32_t)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            cp |= (uint32_t)(c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+    *out = cp;
+    return true;
+}
+
+// the opening quote has already been consumed
+static bool jsstream_read_string(jsstream* s)
+{
+    for (;;) {
+        int c = jsstream_getc(s);
+        if (c < 0) {
+            return false;
+        }
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\') {
+            jsstream_putc(s, (char)c);
+            continue;
+        }
+
+        c = jsstream_getc(s);
+        switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            jsstream_putc(s, (char)c);
+            break;
+        case 'b':
+            jsstream_putc(s, '\b');
+            break;
+        case 'f':
+            jsstream_putc(s, '\f');
+            break;
+        case 'n':
+            jsstream_putc(s, '\n');
+            break;
+        case 'r':
+            jsstream_putc(s, '\r');
+            break;
+        case 't':
+            jsstream_putc(s, '\t');
+            break;
+        case 'u': {
+            uint32_t cp;
+            if (!jsstream_read_hex4(s, &cp)) {
+                return false;
+            }
+            // surrogate pairs come as two escapes
+            if (cp >= 0xd800 && cp < 0xdc00 && jsstream_getc(s) == '\\'
+                && jsstream_getc(s) == 'u') {
+                uint32_t low;
+                if (!jsstream_read_hex4(s, &low)) {
+                    return false;
+                }
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            }
+            jsstream_put_utf8(s, cp);
+        } break;
+        default:
+            return false;
+        }
+    }
+}
+
+static bool jsstream_is_primitive_char(int c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.'
+           || c == 'E';
+}
+
+static jsevent jsstream_read_primitive(jsstream* s)
+{
+    while (jsstream_is_primitive_char(jsstream_peek(s))) {
+        jsstream_putc(s, (char)jsstream_getc(s));
+    }
+    s->value[s->value_len] = '\0';
+
+    if (strcmp(s->value, "true") == 0 || strcmp(s->value, "false") == 0) {
+        s->boolean = s->value[0] == 't';
+        return JsEvent_Bool;
+    }
+    if (strcmp(s->value, "null") == 0) {
+        return JsEvent_Null;
+    }
+
+    char* end = NULL;
+    errno = 0;
+    s->number = strtod(s->value, &end);
+    if (s->value_len == 0 || *end != '\0' || errno != 0) {
+        return JsEvent_Error;
+    }
+    return JsEvent_Number;
+}
+
+// values inside an object are followed by another key
+static void jsstream_end_value(jsstream* s)
+{
+    s->want_key = s->depth > 0 && s->stack[s->depth - 1] == '{';
+}
+
+jsevent jsstream_next(jsstream* s)
+{
+    if (s->event == JsEvent_Error) {
+        return JsEvent_Error;
+    }
+
+    s->value_len = 0;
+    s->truncated = false;
+
+    int c;
+    do {
+        c = jsstream_getc(s);
+    } while (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == ':');
+
+    switch (c) {
+    case -1:
+        if (s->depth > 0) {
+            return jsstream_fail(s, "unexpected end of input");
+        }
+        s->event = JsEvent_End;
+        break;
+    case '{':
+    case '[':
+        if (s->depth == K_JSSTREAM_MAX_DEPTH) {
+            return jsstream_fail(s, "nested too deep");
+        }
+        s->stack[s->depth++] = (uint8_t)c;
+        s->want_key = c == '{';
+        s->event = (c == '{') ? JsEvent_ObjectBegin : JsEvent_ArrayBegin;
+        break;
+    case '}':
+    case ']':
+        if (s->depth == 0 || s->stack[s->depth - 1] != ((c == '}') ? '{' : '[')) {
+            return jsstream_fail(s, "mismatched bracket");
+        }
+        --s->depth;
+        jsstream_end_value(s);
+        s->event = (c == '}') ? JsEvent_ObjectEnd : JsEvent_ArrayEnd;
+        break;
+    case '"':
+        if (!jsstream_read_string(s)) {
+            return jsstream_fail(s, "malformed string");
+        }
+        s->value[s->value_len] = '\0';
+        if (s->want_key) {
+            s->want_key = false;
+            s->event = JsEvent_Key;
+        } else {
+            jsstream_end_value(s);
+            s->event = JsEvent_String;
+        }
+        break;
+    default:
+        s->value[s->value_len++] = (char)c;
+        s->event = jsstream_read_primitive(s);
+        if (s->event == JsEvent_Error) {
+            return jsstream_fail(s, "malformed value");
+        }
+        jsstream_end_value(s);
+        break;
+    }
+
+    return s->event;
+}
+
+void jsstream_skip(jsstream* s)
+{
+    if (s->event != JsEvent_ObjectBegin && s->event != JsEvent_ArrayBegin) {
+        return;
+    }
+
+    const int32_t depth = s->depth - 1;
+    while (s->depth > depth) {
+        const jsevent event = jsstream_next(s);
+        if (event == JsEvent_Error || event == JsEvent_End) {
+            return;
+        }
+    }
+}
+
+bool jsstream_eq(const jsstream* s, const char* str)
+{
+    return (s->event == JsEvent_Key || s->event == JsEvent_String) && strcmp(s->value, str) == 0;
+}
+
+void jsstream_bind_value(jsstream* s, jsfield* field, void* member)
+{
+    switch (field->type) {
+    case JsField_Int:
+        if (s->event == JsEvent_Number) {
+            jsfield_set_int(field, member, (int64_t)s->number);
+        }
+        break;
+    case JsField_Float:
+        if (s->event == JsEvent_Number) {
+            *(float*)member = (float)s->number;
+        }
+        break;
+    case JsField_Bool:
+        if (s->event == JsEvent_Bool) {
+            *(bool*)member = s->boolean;
+        }
+        break;
+    case JsField_String:
+        if (s->event == JsEvent_String && field->size > 0) {
+            size_t len = (size_t)s->value_len;
+            len = (len < field->size - 1) ? len : field->size - 1;
+            memcpy(member, s->value, len);
+            ((char*)member)[len] = '\0';
+        }
+        break;
+    case JsField_Object:
+        if (s->event == JsEvent_ObjectBegin) {
+            jsstream_bind(s, field->object, member);
+            return;
+        }
+        break;
+    case JsField_Enum:
+        if (s->event == JsEvent_String) {
+            for (int e = 0; e < field->enum_count; ++e) {
+                if (strcmp(s->value, field->enum_names[e]) == 0) {
+                    *(int*)member = e;
+                    break;
+                }
+            }
+        }
+        break;
+    case JsField_Token:
+        break;
+    }
+
+    jsstream_skip(s);
+}
+
+bool jsstream_bind(jsstream* s, jsobject_desc* desc, void* out)
+{
+    if (s->event != JsEvent_ObjectBegin) {
+        return false;
+    }
+
+    jsevent event;
+    while ((event = jsstream_next(s)) == JsEvent_Key) {
+        jsfield* field = jsobject_find(desc, s->value, (size_t)s->value_len);
+        jsstream_next(s);
+        if (field) {
+            jsstream_bind_value(s, field, (uint8_t*)out + field->offset);
+        } else {
+            jsstream_skip(s);
+        }
+    }
+
+    return event == JsEvent_ObjectEnd;
+}
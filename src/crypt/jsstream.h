@@ -0,0 +1,95 @@
+// jsstream.h - Streaming JSON Reader
+// Pull parser that reads a file through a fixed size chunk buffer and hands back one event at a
+// time, so memory use doesn't depend on the size of the file. Objects can be bound straight onto
+// structs with the jsfield descriptors from jsonutil.h.
+//
+//   jsstream* s = malloc(sizeof(jsstream));
+//   if (jsstream_open(s, "assets/level.json") == TX_SUCCESS) {
+//       if (jsstream_next(s) == JsEvent_ObjectBegin) {
+//           while (jsstream_next(s) == JsEvent_Key) {
+//               if (jsstream_eq(s, "video")) {
+//                   jsstream_next(s);
+//                   jsstream_bind(s, &video_desc, &video);
+//               } else {
+//                   jsstream_next(s);
+//                   jsstream_skip(s);
+//               }
+//           }
+//       }
+//       jsstream_close(s);
+//   }
+//
+// The reader is lenient in the same way jsmn is, commas and colons are treated as separators and
+// aren't checked, but unbalanced brackets and malformed values are reported as JsEvent_Error.
+
+#pragma once
+
+#include "jsonutil.h"
+#include "tx_types.h"
+
+#include <stdio.h>
+
+enum {
+    K_JSSTREAM_CHUNK_SIZE = 16 * 1024,
+    // longer strings are truncated, jsstream.truncated is set when it happens
+    K_JSSTREAM_MAX_VALUE = 1024,
+    K_JSSTREAM_MAX_DEPTH = 64,
+};
+
+typedef enum jsevent {
+    JsEvent_ObjectBegin,
+    JsEvent_ObjectEnd,
+    JsEvent_ArrayBegin,
+    JsEvent_ArrayEnd,
+    // object key, the text is in jsstream.value
+    JsEvent_Key,
+    JsEvent_String,
+    // jsstream.number holds the value, jsstream.value the text it was parsed from
+    JsEvent_Number,
+    JsEvent_Bool,
+    JsEvent_Null,
+    JsEvent_End,
+    JsEvent_Error,
+} jsevent;
+
+typedef struct jsstream {
+    jsevent event;
+    char value[K_JSSTREAM_MAX_VALUE];
+    int32_t value_len;
+    bool truncated;
+    double number;
+    bool boolean;
+    // set along with JsEvent_Error
+    const char* error;
+
+    // bytes read before the current chunk, offset + pos is the position in the file
+    size_t offset;
+    const char* buf;
+    size_t len;
+    size_t pos;
+    FILE* file;
+    char chunk[K_JSSTREAM_CHUNK_SIZE];
+
+    uint8_t stack[K_JSSTREAM_MAX_DEPTH];
+    int32_t depth;
+    bool want_key;
+} jsstream;
+
+tx_result jsstream_open(jsstream* s, const char* filename);
+// Reads from memory instead of a file, js must stay alive until the stream is done with.
+void jsstream_init(jsstream* s, const char* js, size_t len);
+void jsstream_close(jsstream* s);
+
+jsevent jsstream_next(jsstream* s);
+// Skips the rest of the value the last event started, a no-op unless it began an object or array.
+void jsstream_skip(jsstream* s);
+// Whether the last key or string is str.
+bool jsstream_eq(const jsstream* s, const char* str);
+
+// Binds the value the last event started onto the member field describes. JsField_Token has no
+// meaning for a stream, those values are skipped.
+void jsstream_bind_value(jsstream* s, jsfield* field, void* member);
+// Binds the object the last JsEvent_ObjectBegin started onto out and consumes it up to and
+// including its JsEvent_ObjectEnd, unknown keys are skipped. Returns false on a read error or
+// if the last event didn't begin an object.
+bool jsstream_bind(jsstream* s, jsobject_desc* desc, void* out);
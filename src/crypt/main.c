@@ -2,14 +2,21 @@
 #include "curves.h"
 #include "debug_gui.h"
 #include "game_components.h"
+#include "file_watch.h"
+#include "frame_arena.h"
+#include "futils.h"
+#include "jobs.h"
+#include "jsstream.h"
 #include "physics.h"
 #include "profile.h"
+#include "scene.h"
 #include "sprite_renderer.h"
 #include "system_imgui.h"
 #include "system_sdl2.h"
 #include "tx_input.h"
 #include "tx_math.h"
 #include "tx_rand.h"
+#include "world_snapshot.h"
 #include <SDL2/SDL.h>
 #include <ccimgui.h>
 #include <time.h>
@@ -76,6 +83,18 @@ typedef struct InvaderControlContext {
     float last_step_y;
     float step_timer;
     int32_t invaders_alive;
+    // set by AddInvaders, the wave is spawned by spawn_pending_invaders between frames
+    bool spawn_pending;
+    struct {
+        ecs_id_t position;
+        ecs_id_t local_position;
+        ecs_id_t velocity;
+        ecs_id_t collider;
+        ecs_id_t label;
+    } spawn_ids;
+    // the wave as it was spawned, captured on the first update after it was spawned
+    world_snapshot* wave;
+    bool wave_captured;
 } InvaderControlContext;
 
 typedef struct InvaderPosition {
@@ -102,6 +121,8 @@ typedef struct DamageConfig {
     float amount;
 } DamageConfig;
 
+STR_ID_DECLARE(InvaderRoot);
+
 ECS_COMPONENT_DECLARE(Target);
 ECS_COMPONENT_DECLARE(Bounds);
 ECS_COMPONENT_DECLARE(ExpireAfter);
@@ -117,6 +138,15 @@ ECS_COMPONENT_DECLARE(MaxHealth);
 ECS_COMPONENT_DECLARE(Damage);
 ECS_COMPONENT_DECLARE(DamageConfig);
 
+static jsfield invader_config_fields[] = {JSFIELD(JsField_Float, InvaderConfig, smooth)};
+static jsobject_desc invader_config_desc = JSOBJECT(invader_config_fields);
+static jsfield max_health_fields[] = {JSFIELD(JsField_Float, MaxHealth, value)};
+static jsobject_desc max_health_desc = JSOBJECT(max_health_fields);
+static jsfield expire_after_fields[] = {JSFIELD(JsField_Float, ExpireAfter, seconds)};
+static jsobject_desc expire_after_desc = JSOBJECT(expire_after_fields);
+static jsfield damage_config_fields[] = {JSFIELD(JsField_Float, DamageConfig, amount)};
+static jsobject_desc damage_config_desc = JSOBJECT(damage_config_fields);
+
 //// TAGS
 ECS_TAG_DECLARE(Projectile);
 ECS_TAG_DECLARE(Friendly);
@@ -127,7 +157,9 @@ void UpdatePositionHeirarchy(ecs_iter_t* it);
 void InvaderRootControl(ecs_iter_t* it);
 void InvaderMovement(ecs_iter_t* it);
 void AddInvaders(ecs_iter_t* it);
+void spawn_pending_invaders(ecs_world_t* world, ecs_entity_t e_control);
 void RemoveInvaders(ecs_iter_t* it);
+void CameraControl(ecs_iter_t* it);
 void TankGatherInput(ecs_iter_t* it);
 void TankControl(ecs_iter_t* it);
 void Move(ecs_iter_t* it);
@@ -176,17 +208,20 @@ void tank_debug_gui(ecs_world_t* world, void* ctx)
 
 typedef struct invader_control_debug_context {
     ecs_entity_t e_control;
+    DEBUG_PANEL_DECLARE_COMPONENT(Position);
 } invader_control_debug_context;
 
 void invader_control_debug_gui(ecs_world_t* world, void* ctx)
 {
     invader_control_debug_context* context = (invader_control_debug_context*)ctx;
+    DEBUG_PANEL_LOAD_COMPONENT(context, Position);
 
     const InvaderControlContext* control =
         ecs_get(world, context->e_control, InvaderControlContext);
     InvadersConfig* config = ecs_get_mut(world, context->e_control, InvadersConfig, false);
 
     bool needs_reset = false;
+    bool needs_respawn = false;
 
     if (igButton("RESET", (ImVec2){-1, 30})) {
         needs_reset = true;
@@ -194,8 +229,15 @@ void invader_control_debug_gui(ecs_world_t* world, void* ctx)
 
     igLabelText("Alive", "%d", control->invaders_alive);
     igLabelText("Total", "%d", config->invader_rows * config->invader_cols);
-    needs_reset |= igInputInt("Rows", &config->invader_rows, 1, 5, ImGuiInputTextFlags_None);
-    needs_reset |= igInputInt("Cols", &config->invader_cols, 1, 5, ImGuiInputTextFlags_None);
+    if (control->wave_captured) {
+        igLabelText(
+            "Snapshot",
+            "%d entities, %.1f KB",
+            world_snapshot_entity_count(control->wave),
+            world_snapshot_size(control->wave) / 1024.0f);
+    }
+    needs_respawn |= igInputInt("Rows", &config->invader_rows, 1, 5, ImGuiInputTextFlags_None);
+    needs_respawn |= igInputInt("Cols", &config->invader_cols, 1, 5, ImGuiInputTextFlags_None);
     igInputFloat2("Spacing", &config->spacing.x, "%0.2f", ImGuiInputTextFlags_None);
     igInputFloat(
         "Min Interval", &config->min_step_interval, 0.01f, 0.1f, "%.05f", ImGuiInputTextFlags_None);
@@ -203,7 +245,29 @@ void invader_control_debug_gui(ecs_world_t* world, void* ctx)
         "Max Interval", &config->max_step_interval, 0.01f, 0.1f, "%.05f", ImGuiInputTextFlags_None);
     igInputFloat2("Step Dist", &config->step_dist.x, "%0.2f", ImGuiInputTextFlags_None);
 
-    if (needs_reset) {
+    // labels are only formatted while the list is open
+    if (igCollapsingHeaderTreeNodeFlags("Invaders", ImGuiTreeNodeFlags_None)) {
+        ecs_iter_t qit = ecs_query_iter(control->q_invaders);
+        while (ecs_query_next(&qit)) {
+            const Position* pos = ecs_term(&qit, Position, 2);
+            for (int32_t i = 0; i < qit.count; ++i) {
+                char label[64];
+                igText(
+                    "%s (%.1f, %.1f)",
+                    debug_entity_label(world, qit.entities[i], label, sizeof(label)),
+                    pos[i].x,
+                    pos[i].y);
+            }
+        }
+    }
+
+    // the same wave again comes back from the snapshot, a different one has to be spawned
+    if (needs_reset && !needs_respawn && control->wave_captured) {
+        world_snapshot_restore(world, control->wave);
+        ecs_entity_t root_ent = scene_lookup_symbol(world, STR_ID(InvaderRoot));
+        Position* root = ecs_get_mut(world, root_ent, Position, false);
+        *root = (vec2){-14, -8};
+    } else if (needs_reset || needs_respawn) {
         ecs_remove(world, context->e_control, InvadersConfig);
         ecs_set_id(
             world, context->e_control, ecs_id(InvadersConfig), sizeof(InvadersConfig), config);
@@ -220,17 +284,167 @@ void bullet_contact_start(ecs_world_t* world, ecs_entity_t self, ecs_entity_t ot
     ecs_delete(world, self);
 }
 
+typedef struct bench_entity {
+    char name[32];
+    char prefab[32];
+    vec2 position;
+    int health;
+} bench_entity;
+
+static jsfield bench_position_fields[] = {
+    JSFIELD(JsField_Float, vec2, x),
+    JSFIELD(JsField_Float, vec2, y),
+};
+static jsobject_desc bench_position_desc = JSOBJECT(bench_position_fields);
+
+static jsfield bench_entity_fields[] = {
+    JSFIELD(JsField_String, bench_entity, name),
+    JSFIELD(JsField_String, bench_entity, prefab),
+    JSFIELD_OBJECT(bench_entity, position, &bench_position_desc),
+    JSFIELD(JsField_Int, bench_entity, health),
+};
+static jsobject_desc bench_entity_desc = JSOBJECT(bench_entity_fields);
+
+// Writes a level shaped file of roughly megabytes MB and binds every entity in it, once through
+// the stream reader and once through jsparse + jsbind, to compare time and memory.
+void bench_json(int32_t megabytes)
+{
+    const char* filename = "bench_level.json";
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        ecs_os_err("failed to write %s", filename);
+        return;
+    }
+
+    const size_t target = (size_t)megabytes * 1024 * 1024;
+    size_t written = fprintf(file, "{\n    \"entities\": [");
+    for (int32_t i = 0; written < target; ++i) {
+        written += fprintf(
+            file,
+            "%s\n        {\"name\": \"invader_%06d\", \"prefab\": \"Invader\", "
+            "\"position\": {\"x\": %.3f, \"y\": %.3f}, \"health\": %d, "
+            "\"tags\": [\"enemy\", \"row_%d\"]}",
+            (i > 0) ? "," : "",
+            i,
+            txrng_rangef(-20.0f, 20.0f),
+            txrng_rangef(0.0f, 12.0f),
+            i % 5 + 1,
+            i % 8);
+    }
+    written += fprintf(file, "\n    ]\n}\n");
+    fclose(file);
+
+    const double freq = (double)SDL_GetPerformanceFrequency();
+    bench_entity entity;
+    float checksum = 0.0f;
+
+    // stream, memory is the reader itself
+    uint64_t start = SDL_GetPerformanceCounter();
+    int32_t stream_count = 0;
+    jsstream* s = malloc(sizeof(jsstream));
+    if (jsstream_open(s, filename) == TX_SUCCESS) {
+        jsstream_next(s);
+        while (jsstream_next(s) == JsEvent_Key) {
+            jsstream_next(s);
+            if (s->event == JsEvent_ArrayBegin) {
+                while (jsstream_next(s) == JsEvent_ObjectBegin) {
+                    jsstream_bind(s, &bench_entity_desc, &entity);
+                    checksum += entity.position.x;
+                    ++stream_count;
+                }
+            }
+            jsstream_skip(s);
+        }
+        jsstream_close(s);
+    }
+    free(s);
+    const double stream_ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / freq;
+
+    // tokens, memory is the mapped file and the token array
+    start = SDL_GetPerformanceCounter();
+    int32_t token_count = 0;
+    size_t token_bytes = 0;
+    file_view view;
+    if (file_map(filename, &view) == TX_SUCCESS) {
+        jsmntok_t* tokens = NULL;
+        if (jsparse(view.data, view.len, &tokens) > 0) {
+            int entities_id = jsget_id(view.data, tokens, 0, "entities");
+            int entity_id = entities_id + 1;
+            for (int i = 0; entities_id >= 0 && i < tokens[entities_id].size; ++i) {
+                entity_id = jsbind(view.data, tokens, entity_id, &bench_entity_desc, &entity);
+                checksum -= entity.position.x;
+                ++token_count;
+            }
+        }
+        token_bytes = arrcap(tokens) * sizeof(jsmntok_t);
+        arrfree(tokens);
+        file_unmap(&view);
+    }
+    const double token_ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / freq;
+
+    remove(filename);
+
+    const double megs = written / (1024.0 * 1024.0);
+    printf("json bench: %.1f MB, %d entities (checksum %g)\n", megs, stream_count, checksum);
+    printf(
+        "  jsstream       %8.1f ms  %8.1f MB/s  %10zu bytes\n",
+        stream_ms,
+        megs / (stream_ms / 1000.0),
+        sizeof(jsstream));
+    printf(
+        "  jsparse+jsbind %8.1f ms  %8.1f MB/s  %10zu bytes (%d entities)\n",
+        token_ms,
+        megs / (token_ms / 1000.0),
+        written + token_bytes,
+        token_count);
+}
+
 int main(int argc, char* argv[])
 {
     PROFILE_INIT();
 
     txrng_seed((uint32_t)time(NULL));
     str_id_init();
+    STR_ID_DEFINE(InvaderRoot);
+    jobs_init(SDL_GetCPUCount() - 1);
+    file_watch_init();
+    frame_arena_init(K_FRAME_ARENA_DEFAULT_SIZE);
 
     ecs_tracing_enable(1);
 
+    // --bench-frames N runs N uncapped frames, then dumps the render stats and quits
+    // --bench-json MB loads a generated MB sized level file with both json readers and quits
+    // --compact-instances, --integer-scale and --skip-unchanged-canvas opt in to the renderer's
+    //   alternate paths, the last two can also be toggled from the debug panel
+    int32_t bench_frames = 0;
+    sprite_instance_format instance_format = SpriteInstanceFormat_Full;
+    sprite_present_mode present_mode = SpritePresentMode_Stretch;
+    bool skip_unchanged_canvas = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--compact-instances") == 0) {
+            instance_format = SpriteInstanceFormat_Compact;
+        } else if (strcmp(argv[i], "--integer-scale") == 0) {
+            present_mode = SpritePresentMode_IntegerScale;
+        } else if (strcmp(argv[i], "--skip-unchanged-canvas") == 0) {
+            skip_unchanged_canvas = true;
+        }
+    }
+    for (int i = 1; i < argc - 1; ++i) {
+        if (strcmp(argv[i], "--bench-frames") == 0) {
+            bench_frames = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--bench-json") == 0) {
+            bench_json(atoi(argv[i + 1]));
+            frame_arena_term();
+            file_watch_term();
+            jobs_term();
+            PROFILE_TERMINATE();
+            str_id_term();
+            return 0;
+        }
+    }
+
     ecs_world_t* world = ecs_init_w_args(argc, argv);
-    ecs_set_target_fps(world, 144.0f);
+    ecs_set_target_fps(world, (bench_frames > 0) ? 0.0f : 144.0f);
     ecs_set_time_scale(world, 1.0f);
 
     ECS_IMPORT(world, GameComp);
@@ -244,19 +458,24 @@ int main(int argc, char* argv[])
     ecs_entity_t window =
         ecs_set(world, EcsWorld, WindowConfig, {.title = "crypt", .width = 1920, .height = 1080});
 
+    // imgui sets up its GL objects while the main thread still has the context, attaching the
+    // renderer hands it to the render thread
+    ecs_set(world, EcsWorld, ImguiDesc, {0});
+
     ecs_entity_t render_config = ecs_set(
         world,
         EcsWorld,
         SpriteRenderConfig,
         {
             .e_window = window,
+            .instance_format = instance_format,
+            .present_mode = present_mode,
+            .skip_unchanged_canvas = skip_unchanged_canvas,
             .pixels_per_meter = 8.0f,
             .canvas_width = 256,
             .canvas_height = 144,
         });
 
-    ecs_set(world, EcsWorld, ImguiDesc, {0});
-
     ECS_COMPONENT_DEFINE(world, Target);
     ECS_COMPONENT_DEFINE(world, Bounds);
     ECS_COMPONENT(world, Facing);
@@ -282,13 +501,25 @@ int main(int argc, char* argv[])
     ECS_TAG_DEFINE(world, Hostile);
     ECS_TAG(world, NoAutoMove);
 
+    SCENE_COMPONENT(world, InvaderConfig, &invader_config_desc);
+    SCENE_COMPONENT(world, MaxHealth, &max_health_desc);
+    SCENE_COMPONENT(world, ExpireAfter, &expire_after_desc);
+    SCENE_COMPONENT(world, DamageConfig, &damage_config_desc);
+
     ECS_ENTITY(world, InvaderRoot, game.comp.Position, Bounds);
     ecs_set(world, InvaderRoot, EcsName, {.value = "InvaderRoot"});
     ecs_set(world, InvaderRoot, Bounds, {INFINITY, -INFINITY, INFINITY, -INFINITY});
 
+    // camera and prefabs, the invaders themselves are spawned by spawn_pending_invaders
+    tx_result scene_result = scene_load(world, "assets/scenes/invaders.json");
+    TX_ASSERT(scene_result == TX_SUCCESS);
+    ecs_entity_t InvaderPrefab = ecs_lookup(world, "InvaderPrefab");
+    ecs_entity_t TankProjectilePrefab = ecs_lookup(world, "TankBullet");
+
     // clang-format off
     ECS_SYSTEM(world, UpdatePositionHeirarchy, EcsPostUpdate,
         CASCADE:game.comp.Position, OWNED:game.comp.LocalPosition, OWNED:game.comp.Position);
+    ECS_SYSTEM(world, CameraControl, EcsOnLoad, sprite.renderer.Camera);
     ECS_SYSTEM(world, TankGatherInput, EcsPostLoad, TankInput);
     ECS_SYSTEM(world, TankControl, EcsOnUpdate,
         game.comp.Position, game.comp.Velocity, TankInput, TankConfig, SYSTEM:TankControlContext);
@@ -298,7 +529,8 @@ int main(int argc, char* argv[])
     ECS_SYSTEM(world, InvaderMovement, EcsOnUpdate,
         game.comp.Position, game.comp.Velocity, InvaderTarget, ANY:InvaderConfig);
     ECS_SYSTEM(world, AddInvaders, EcsOnSet, InvadersConfig, InvaderRoot:game.comp.Position,
-        :game.comp.LocalPosition, :game.comp.Velocity, :physics.Box, :physics.Collider);
+        :game.comp.LocalPosition, :game.comp.Velocity, :physics.Box, :physics.Collider,
+        :debug.gui.Label, InvaderControlContext);
     ECS_SYSTEM(world, RemoveInvaders, EcsUnSet,
         InvaderControlContext, InvadersConfig);
     ECS_SYSTEM(world, Move, EcsOnUpdate,
@@ -319,22 +551,18 @@ int main(int argc, char* argv[])
     ECS_TRIGGER(world, OnInvaderRemoved, EcsOnRemove, InvaderTarget);
     // clang-format on
 
-    ECS_PREFAB(world, InvaderPrefab, sprite.renderer.Sprite, physics.Box, Hostile, NoAutoMove);
-    ecs_set(
-        world,
-        InvaderPrefab,
-        Sprite,
-        {.sprite_id = 2, .layer = 10.0f, .origin = (vec2){0.5f, 0.5f}, .width = 1, .height = 1});
-    ecs_set(world, InvaderPrefab, PhysBox, {.size = {0.5f, 0.5f}});
-    ecs_set(world, InvaderPrefab, InvaderConfig, {.smooth = 0.4f});
-    ecs_set(world, InvaderPrefab, MaxHealth, {.value = 3.0f});
-
     ecs_set(
         world,
         InvaderRootControl,
         InvaderControlContext,
         {
             .q_invaders = ecs_query_new(world, "InvaderTarget, game.comp.Position"),
+            .wave = world_snapshot_new(
+                world,
+                &(world_snapshot_desc){
+                    .queries = {"InvaderTarget", "(ChildOf, InvaderRoot)"},
+                    .refs = {{ecs_id(InvaderTarget), offsetof(InvaderTarget, target_ent)}},
+                }),
         });
     ecs_set(
         world,
@@ -370,24 +598,6 @@ int main(int argc, char* argv[])
     ecs_set(world, Tank, PhysBox, {.size = {.x = 1.0f, .y = 0.5f}});
     ecs_set_trait(world, Tank, PhysBox, PhysCollider, {.layer = 0});
 
-    ECS_PREFAB(
-        world,
-        TankProjectilePrefab,
-        Projectile,
-        ExpireAfter,
-        physics.Box,
-        Friendly,
-        game.comp.Highlight);
-    ecs_set(world, TankProjectilePrefab, EcsName, {.value = "TankBullet"});
-    ecs_set(world, TankProjectilePrefab, DamageConfig, {.amount = 1.0f});
-    ecs_set(world, TankProjectilePrefab, PhysBox, {.size = {.x = 0.125f, .y = 0.25f}});
-    ecs_set(world, TankProjectilePrefab, ExpireAfter, {.seconds = 0.75f});
-    ecs_set(
-        world,
-        TankProjectilePrefab,
-        Sprite,
-        {.sprite_id = 16, .width = 1, .height = 1, .origin = {0.5f, 0.5f}, .layer = 4.0f});
-
     ECS_ENTITY(world, ProjectilePhysReceiver, physics.Receiver);
     ecs_filter_t bullet_filter;
     ecs_filter_init(world, &bullet_filter, &(ecs_filter_desc_t){.expr = "INSTANCEOF | TankBullet"});
@@ -430,13 +640,31 @@ int main(int argc, char* argv[])
         "shift+2",
         invader_control_debug_gui,
         invader_control_debug_context,
-        {.e_control = InvaderRootControl});
+        {
+            .e_control = InvaderRootControl,
+            DEBUG_PANEL_STORE_COMPONENT(world, Position, "game.comp.Position"),
+        });
 
+    int32_t frame = 0;
+    spawn_pending_invaders(world, InvaderRootControl);
     while (ecs_progress(world, 0.0f)) {
+        frame_arena_next_frame();
+        spawn_pending_invaders(world, InvaderRootControl);
+        if (bench_frames > 0 && ++frame >= bench_frames) {
+            break;
+        }
     }
 
+    if (bench_frames > 0) {
+        sprite_renderer_dump_stats(stdout);
+    }
+
+    sprite_renderer_shutdown(world);
     int result = ecs_fini(world);
 
+    frame_arena_term();
+    file_watch_term();
+    jobs_term();
     PROFILE_TERMINATE();
     str_id_term();
 
@@ -463,6 +691,11 @@ void InvaderRootControl(ecs_iter_t* it)
     Position* root = ecs_term(it, Position, 3);
     Bounds* root_bounds = ecs_term(it, Bounds, 4);
 
+    if (!context->wave_captured && !context->spawn_pending) {
+        world_snapshot_capture(it->world, context->wave);
+        context->wave_captured = true;
+    }
+
     if (context->step_timer > 0.0f) {
         context->step_timer -= it->delta_time;
         return;
@@ -559,9 +792,13 @@ void RemoveInvaders(ecs_iter_t* it)
     InvadersConfig* config = ecs_term(it, InvadersConfig, 2);
 
     if (ecs_should_quit(it->world)) {
+        world_snapshot_free(context->wave);
+        context->wave = NULL;
         return;
     }
 
+    context->wave_captured = false;
+
     ecs_iter_t qit = ecs_query_iter(context->q_invaders);
     while (ecs_query_next(&qit)) {
         for (int32_t i = 0; i < qit.count; ++i) {
@@ -572,45 +809,115 @@ void RemoveInvaders(ecs_iter_t* it)
     }
 }
 
+// Systems always run deferred, OnSet ones included, where scene_spawn can only create the entities
+// empty and set their values one by one afterwards. AddInvaders just asks for a wave and
+// spawn_pending_invaders creates it between frames, each batch straight into its table.
 void AddInvaders(ecs_iter_t* it)
 {
-    InvadersConfig* config = ecs_term(it, InvadersConfig, 1);
     Position* root = ecs_term(it, Position, 2);
+    InvaderControlContext* control = ecs_term(it, InvaderControlContext, 8);
 
     *root = (vec2){-14, -8};
 
-    ecs_entity_t root_ent = ecs_lookup(it->world, "InvaderRoot");
+    for (int32_t i = 0; i < it->count; ++i) {
+        control[i].spawn_pending = true;
+        control[i].spawn_ids.position = ecs_term_id(it, 2);
+        control[i].spawn_ids.local_position = ecs_term_id(it, 3);
+        control[i].spawn_ids.velocity = ecs_term_id(it, 4);
+        control[i].spawn_ids.collider = ecs_trait(ecs_term_id(it, 5), ecs_term_id(it, 6));
+        control[i].spawn_ids.label = ecs_term_id(it, 7);
+    }
+}
+
+// Called outside of ecs_progress, where the world isn't deferred.
+void spawn_pending_invaders(ecs_world_t* world, ecs_entity_t e_control)
+{
+    InvaderControlContext* control = ecs_get_mut(world, e_control, InvaderControlContext, false);
+    if (!control->spawn_pending) {
+        return;
+    }
+    control->spawn_pending = false;
+
+    // the config can be gone again before the wave was spawned
+    const InvadersConfig* config = ecs_get(world, e_control, InvadersConfig);
+    if (!config) {
+        return;
+    }
+
+    ecs_id_t ecs_id(Position) = control->spawn_ids.position;
+    ecs_id_t ecs_id(LocalPosition) = control->spawn_ids.local_position;
+    ecs_id_t ecs_id(Velocity) = control->spawn_ids.velocity;
+    ecs_id_t ecs_id(DebugLabel) = control->spawn_ids.label;
+    ecs_id_t collider_id = control->spawn_ids.collider;
 
-    ecs_id_t ecs_id(Position) = ecs_term_id(it, 2);
-    ecs_id_t ecs_id(LocalPosition) = ecs_term_id(it, 3);
-    ecs_id_t ecs_id(Velocity) = ecs_term_id(it, 4);
-    ecs_id_t ecs_id(PhysBox) = ecs_term_id(it, 5);
-    ecs_id_t ecs_id(PhysCollider) = ecs_term_id(it, 6);
+    ecs_entity_t root_ent = scene_lookup_symbol(world, STR_ID(InvaderRoot));
+    const Position* root = ecs_get(world, root_ent, Position);
 
     int32_t num_invaders = config->invader_cols * config->invader_rows;
+    if (num_invaders <= 0) {
+        return;
+    }
+
+    vec2* local_positions = malloc(sizeof(vec2) * num_invaders);
+    vec2* positions = malloc(sizeof(vec2) * num_invaders);
+    Velocity* velocities = calloc(num_invaders, sizeof(Velocity));
+    InvaderConfig* invader_configs = malloc(sizeof(InvaderConfig) * num_invaders);
+    InvaderTarget* targets = malloc(sizeof(InvaderTarget) * num_invaders);
+    DebugLabel* labels = malloc(sizeof(DebugLabel) * num_invaders);
+    PhysCollider* colliders = malloc(sizeof(PhysCollider) * num_invaders);
+
     for (int32_t i = 0; i < num_invaders; ++i) {
         uint16_t row = i / config->invader_cols;
         uint16_t col = i % config->invader_cols;
 
-        vec2 local_pos = (vec2){.x = col * config->spacing.x, .y = row * config->spacing.y};
-        vec2 world_pos = vec2_add(*root, local_pos);
-
-        ecs_entity_t invader_target = ecs_new_w_pair(it->world, EcsChildOf, root_ent);
-        ecs_set_ptr(it->world, invader_target, LocalPosition, &local_pos);
-        ecs_set(it->world, invader_target, Position, {0});
+        local_positions[i] = (vec2){.x = col * config->spacing.x, .y = row * config->spacing.y};
+        positions[i] = vec2_add(*root, local_positions[i]);
+        invader_configs[i] = (InvaderConfig){.smooth = (row + 1) * 0.15f};
+        colliders[i] = (PhysCollider){.layer = 1};
+        labels[i] = (DebugLabel){.prefix = "invader", .index = i};
+    }
 
-        ecs_entity_t invader = ecs_new_w_pair(it->world, EcsIsA, config->invader_prefab);
+    // the targets first so the invaders can be created already pointing at them, each batch is
+    // created straight into its final table
+    scene_column target_columns[] = {
+        {.id = ecs_pair(EcsChildOf, root_ent)},
+        {.id = ecs_id(LocalPosition), .size = sizeof(vec2), .data = local_positions},
+        {.id = ecs_id(Position), .size = sizeof(vec2), .data = positions},
+    };
+    const ecs_entity_t* target_ents = scene_spawn(world, target_columns, 3, num_invaders);
+    for (int32_t i = 0; i < num_invaders; ++i) {
+        targets[i] = (InvaderTarget){.target_ent = target_ents[i]};
+    }
 
-        char* buf = malloc(16 * sizeof(char));
-        snprintf(buf, 16, "invader_%03d", i);
+    scene_column invader_columns[] = {
+        {.id = ecs_pair(EcsIsA, config->invader_prefab)},
+        {.id = ecs_id(DebugLabel), .size = sizeof(DebugLabel), .data = labels},
+        {.id = ecs_id(InvaderTarget), .size = sizeof(InvaderTarget), .data = targets},
+        {.id = ecs_id(Position), .size = sizeof(vec2), .data = positions},
+        {.id = ecs_id(Velocity), .size = sizeof(Velocity), .data = velocities},
+        {.id = ecs_id(InvaderConfig), .size = sizeof(InvaderConfig), .data = invader_configs},
+        {.id = collider_id, .size = sizeof(PhysCollider), .data = colliders},
+    };
+    scene_spawn(world, invader_columns, 7, num_invaders);
+
+    free(local_positions);
+    free(positions);
+    free(velocities);
+    free(invader_configs);
+    free(targets);
+    free(labels);
+    free(colliders);
+}
 
-        ecs_set(it->world, invader, EcsName, {.alloc_value = buf});
-        ecs_set(it->world, invader, InvaderTarget, {.target_ent = invader_target});
-        ecs_set_ptr(it->world, invader, Position, &world_pos);
-        ecs_set(it->world, invader, Velocity, {0});
+void CameraControl(ecs_iter_t* it)
+{
+    Camera* camera = ecs_term(it, Camera, 1);
 
-        ecs_set(it->world, invader, InvaderConfig, {.smooth = (row + 1) * 0.15f});
-        ecs_set_trait(it->world, invader, PhysBox, PhysCollider, {.layer = 1});
+    for (int32_t i = 0; i < it->count; ++i) {
+        if (txinp_get_key(TXINP_KEY_A)) camera[i].target.x -= 10.0f * it->delta_time;
+        if (txinp_get_key(TXINP_KEY_D)) camera[i].target.x += 10.0f * it->delta_time;
+        if (txinp_get_key(TXINP_KEY_W)) camera[i].target.y -= 10.0f * it->delta_time;
+        if (txinp_get_key(TXINP_KEY_S)) camera[i].target.y += 10.0f * it->delta_time;
     }
 }
 
@@ -1,7 +1,9 @@
 #include "physics.h"
 #include "debug_gui.h"
+#include "frame_arena.h"
 #include "game_components.h"
 #include "profile.h"
+#include "scene.h"
 #include "sprite_renderer.h"
 #include "stb_ds.h"
 #include <ccimgui.h>
@@ -222,29 +224,34 @@ struct ent_contact {
     ecs_entity_t ent0, ent1;
 };
 
-struct physics_ent* physics_ents = NULL;
-struct ent_contact* contact_queues[ContactType_Count] = {0};
+// Both live in the frame arena. Events can be queued after ProcessContactQueues ran (entities
+// deleted late in the frame) so whatever is left in the queues is carried into the next frame.
+frame_arr physics_ents = {0};
+frame_arr contact_queues[ContactType_Count] = {0};
 
-void contact_queues_init(void)
+void contact_queues_carry(void)
 {
     // Skip None, no need for a queue
     for (int i = ContactType_Start; i < ContactType_Count; ++i) {
-        arrsetcap(contact_queues[i], 32);
-        size_t len = arrlen(contact_queues[i]);
+        frame_arr_carry(
+            &contact_queues[i], sizeof(struct ent_contact), FRAME_ALIGNOF(struct ent_contact));
     }
 }
 
 void contact_queues_free(void)
 {
     for (int i = ContactType_Start; i < ContactType_Count; ++i) {
-        arrfree(contact_queues[i]);
+        contact_queues[i] = (frame_arr){0};
     }
 }
 
 void contact_queues_push(ecs_entity_t e0, ecs_entity_t e1, contact_type type)
 {
     if (type > ContactType_None && type < ContactType_Count) {
-        arrput(contact_queues[type], ((struct ent_contact){.ent0 = e0, .ent1 = e1}));
+        frame_arr_push(
+            contact_queues[type],
+            struct ent_contact,
+            ((struct ent_contact){.ent0 = e0, .ent1 = e1}));
     }
 }
 
@@ -340,7 +347,8 @@ void on_remove_ent(ecs_iter_t* it, PhysReceiver* r, ecs_entity_t e0, ecs_entity_
 
 void PhysicsNewFrame(ecs_iter_t* it)
 {
-    arrsetlen(physics_ents, 0);
+    physics_ents = (frame_arr){0};
+    contact_queues_carry();
 }
 
 void GatherColliders(ecs_iter_t* it)
@@ -351,8 +359,9 @@ void GatherColliders(ecs_iter_t* it)
     const PhysCollider* collider = ecs_term(it, PhysCollider, 3);
 
     for (int32_t i = 0; i < it->count; ++i) {
-        arrput(
+        frame_arr_push(
             physics_ents,
+            struct physics_ent,
             ((struct physics_ent){
                 .ent = it->entities[i],
                 .bounds = bounds[i],
@@ -367,11 +376,12 @@ void UpdateContactEvents(ecs_iter_t* it)
 {
     PROFILE_BEGIN(UpdateContactEvents);
 
-    int32_t len = (int32_t)arrlen(physics_ents);
+    struct physics_ent* ents = frame_arr_items(physics_ents, struct physics_ent);
+    int32_t len = physics_ents.count;
     for (int32_t i = 0; i < len - 1; ++i) {
         for (int32_t j = i + 1; j < len; ++j) {
-            struct physics_ent* a = &physics_ents[i];
-            struct physics_ent* b = &physics_ents[j];
+            struct physics_ent* a = &ents[i];
+            struct physics_ent* b = &ents[j];
 
             if (a->layer == b->layer) {
                 continue;
@@ -408,13 +418,14 @@ void ProcessContactQueues(ecs_iter_t* it)
     PhysReceiver* r = ecs_term(it, PhysReceiver, 1);
 
     for (contact_type qtype = ContactType_Start; qtype < ContactType_Count; ++qtype) {
-        struct ent_contact* queue = contact_queues[qtype];
-        size_t len = arrlen(queue);
-        for (size_t i = 0; i < len; ++i) {
+        const struct ent_contact* queue =
+            frame_arr_items(contact_queues[qtype], struct ent_contact);
+        int32_t len = contact_queues[qtype].count;
+        for (int32_t i = 0; i < len; ++i) {
             ecs_entity_t ent0 = queue[i].ent0, ent1 = queue[i].ent1;
             contact_type_notify_actions[qtype](it, r, ent0, ent1);
         }
-        arrsetlen(contact_queues[qtype], 0);
+        contact_queues[qtype] = (frame_arr){0};
     }
 
     PROFILE_END();
@@ -557,12 +568,15 @@ void physics_fini(ecs_world_t* world, void* ctx)
     contact_queues_free();
 }
 
+static jsfield box_fields[] = {
+    JSFIELD_OBJECT(PhysBox, size, &scene_vec2_desc),
+};
+static jsobject_desc box_desc = JSOBJECT(box_fields);
+
 void PhysicsImport(ecs_world_t* world)
 {
     ECS_MODULE(world, Physics);
 
-    contact_queues_init();
-
     ecs_atfini(world, physics_fini, NULL);
 
     ecs_set_name_prefix(world, "Phys");
@@ -571,6 +585,8 @@ void PhysicsImport(ecs_world_t* world)
     ECS_COMPONENT(world, PhysBox);
     ECS_COMPONENT(world, PhysWorldBounds);
 
+    SCENE_COMPONENT(world, PhysBox, &box_desc);
+
     ECS_TAG(world, ClearPhysEnts);
     ECS_ENTITY(world, ClearEnt, ClearPhysEnts);
 
@@ -0,0 +1,69 @@
+#include "render_cmds.h"
+#include "stb_ds.h"
+
+#include <string.h>
+
+enum { K_RENDER_CMD_ALIGN = 16 };
+
+static struct {
+    struct render_cmd_list lists[RenderCmdStage_Count];
+    bool deferred;
+} recorder;
+
+void render_cmd_push(render_cmd_stage stage, render_cmd_fn fn, const void* data, size_t size)
+{
+    // callers always pass their own temporary so it stands in for the copy
+    if (!recorder.deferred) {
+        fn((void*)data);
+        return;
+    }
+
+    struct render_cmd_list* list = &recorder.lists[stage];
+
+    // stb_ds arrays are malloc aligned so the offsets keep every copy aligned
+    const size_t offset = (arrlenu(list->data) + K_RENDER_CMD_ALIGN - 1)
+                          & ~(size_t)(K_RENDER_CMD_ALIGN - 1);
+    arrsetlen(list->data, offset + size);
+    memcpy(&list->data[offset], data, size);
+
+    arrput(list->cmds, ((struct render_cmd){.fn = fn, .offset = offset}));
+}
+
+void render_cmds_set_deferred(bool deferred)
+{
+    recorder.deferred = deferred;
+
+    if (!deferred) {
+        for (int32_t i = 0; i < RenderCmdStage_Count; ++i) {
+            render_cmd_list_run(&recorder.lists[i]);
+            render_cmd_list_free(&recorder.lists[i]);
+        }
+    }
+}
+
+void render_cmds_take(struct render_cmd_list lists[RenderCmdStage_Count])
+{
+    for (int32_t i = 0; i < RenderCmdStage_Count; ++i) {
+        TX_ASSERT(arrlen(lists[i].cmds) == 0);
+
+        struct render_cmd_list taken = recorder.lists[i];
+        recorder.lists[i] = lists[i];
+        lists[i] = taken;
+    }
+}
+
+void render_cmd_list_run(struct render_cmd_list* list)
+{
+    for (int32_t i = 0; i < arrlen(list->cmds); ++i) {
+        list->cmds[i].fn(&list->data[list->cmds[i].offset]);
+    }
+
+    arrsetlen(list->cmds, 0);
+    arrsetlen(list->data, 0);
+}
+
+void render_cmd_list_free(struct render_cmd_list* list)
+{
+    arrfree(list->cmds);
+    arrfree(list->data);
+}
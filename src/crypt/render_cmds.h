@@ -0,0 +1,44 @@
+// render_cmds.h - Render Commands
+// Work that needs the GL context (texture uploads, shader rebuilds, imgui draw data) is recorded as
+// a function and a copy of its arguments. The sprite renderer hands everything recorded during a
+// frame to its render thread with the frame packet, where the commands run in the order they were
+// pushed. While commands aren't deferred (before the render thread starts and after it exits) they
+// run right away on the calling thread.
+// Main thread only, apart from running the lists that were taken.
+
+#pragma once
+
+#include "tx_types.h"
+
+typedef void (*render_cmd_fn)(void* data);
+
+typedef enum render_cmd_stage {
+    // before any of the frame is drawn, resource uploads and replacements
+    RenderCmdStage_Frame = 0,
+    // on top of the presented frame once the sokol passes are committed
+    RenderCmdStage_Overlay,
+    RenderCmdStage_Count,
+} render_cmd_stage;
+
+struct render_cmd {
+    render_cmd_fn fn;
+    size_t offset; // of the arguments in render_cmd_list.data
+};
+
+// stb_ds arrays, the arguments of every command are packed into one buffer
+struct render_cmd_list {
+    struct render_cmd* cmds;
+    uint8_t* data;
+};
+
+// data is copied, fn gets a pointer to the copy that is aligned for any argument struct
+void render_cmd_push(render_cmd_stage stage, render_cmd_fn fn, const void* data, size_t size);
+
+// Records commands until they're taken instead of running them. Turning it off runs anything that
+// was recorded and not taken.
+void render_cmds_set_deferred(bool deferred);
+// Exchanges the recorded commands with lists, which have to be empty.
+void render_cmds_take(struct render_cmd_list lists[RenderCmdStage_Count]);
+// Runs every command of the list and empties it, the memory is kept for the next take.
+void render_cmd_list_run(struct render_cmd_list* list);
+void render_cmd_list_free(struct render_cmd_list* list);
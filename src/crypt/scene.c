@@ -0,0 +1,745 @@
+#include "scene.h"
+#include "jsstream.h"
+#include "stb_ds.h"
+#include "tx_math.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { K_SCENE_NAME_MAX = 256, K_SCENE_DATA_ALIGN = 16 };
+
+static struct {
+    ecs_entity_t key;
+    jsobject_desc* value;
+}* scene_descs = NULL;
+
+// keyed by the symbol's hash, symbol tells collisions apart
+static struct scene_symbol {
+    uint32_t key;
+    str_id symbol;
+    ecs_entity_t value;
+}* scene_symbols = NULL;
+
+static jsfield vec2_fields[] = {
+    JSFIELD(JsField_Float, vec2, x),
+    JSFIELD(JsField_Float, vec2, y),
+};
+jsobject_desc scene_vec2_desc = JSOBJECT(vec2_fields);
+
+static void scene_fini(ecs_world_t* world, void* ctx)
+{
+    hmfree(scene_descs);
+}
+
+void scene_register_component(ecs_world_t* world, ecs_entity_t component, jsobject_desc* desc)
+{
+    if (!scene_descs) {
+        ecs_atfini(world, scene_fini, NULL);
+    }
+    hmput(scene_descs, component, desc);
+}
+
+static void scene_symbols_fini(ecs_world_t* world, void* ctx)
+{
+    hmfree(scene_symbols);
+}
+
+ecs_entity_t scene_lookup_symbol(ecs_world_t* world, str_id symbol)
+{
+    const ptrdiff_t index = hmgeti(scene_symbols, symbol.hash);
+    if (index >= 0
+        && str_id_eq(scene_symbols[index].symbol, symbol)
+        && ecs_is_alive(world, scene_symbols[index].value)) {
+        return scene_symbols[index].value;
+    }
+
+    ecs_entity_t e = ecs_lookup_fullpath(world, str_id_cstr(symbol));
+    if (e) {
+        if (!scene_symbols) {
+            ecs_atfini(world, scene_symbols_fini, NULL);
+        }
+        hmputs(scene_symbols, ((struct scene_symbol){.key = symbol.hash, .symbol = symbol, .value = e}));
+    }
+    return e;
+}
+
+const ecs_entity_t* scene_spawn(
+    ecs_world_t* world, const scene_column* columns, int32_t column_count, int32_t count)
+{
+    TX_ASSERT(column_count <= K_SCENE_MAX_COLUMNS);
+    if (count == 0 || column_count > K_SCENE_MAX_COLUMNS) {
+        return NULL;
+    }
+
+    // the data arrays are matched to the table's type rather than the order they're passed in,
+    // types are sorted by id so sort the columns the same way
+    ecs_entity_t ids[K_SCENE_MAX_COLUMNS];
+    void* data[K_SCENE_MAX_COLUMNS];
+    for (int32_t c = 0; c < column_count; ++c) {
+        int32_t i = c;
+        for (; i > 0 && ids[i - 1] > columns[c].id; --i) {
+            ids[i] = ids[i - 1];
+            data[i] = data[i - 1];
+        }
+        ids[i] = columns[c].id;
+        data[i] = (void*)columns[c].data;
+    }
+
+    ecs_ids_t type = {.array = ids, .count = column_count};
+
+    if (!ecs_is_deferred(world)) {
+        return ecs_bulk_new_w_data(world, count, &type, data);
+    }
+
+    // deferred bulk creation copies values one component at a time, moving every entity through
+    // a table per component, so the entities are created without values (a single move into the
+    // final table when the queue is flushed) and the values are set in place afterwards
+    const ecs_entity_t* entities = ecs_bulk_new_w_data(world, count, &type, NULL);
+    for (int32_t c = 0; c < column_count; ++c) {
+        if (!columns[c].data) {
+            continue;
+        }
+        const uint8_t* value = columns[c].data;
+        for (int32_t i = 0; i < count; ++i, value += columns[c].size) {
+            ecs_set_id(world, entities[i], columns[c].id, columns[c].size, value);
+        }
+    }
+
+    return entities;
+}
+
+//// COMPILING
+
+struct scene_build_component {
+    char* name;
+    uint32_t size;
+    jsobject_desc* desc;
+};
+
+struct scene_build_batch {
+    uint32_t flags;
+    uint32_t prefab_offset;
+    uint32_t parent_offset;
+    uint32_t entity_count;
+    uint32_t component_count;
+    uint32_t components[K_SCENE_MAX_COLUMNS];
+    uint8_t* columns[K_SCENE_MAX_COLUMNS];
+    char* names;
+};
+
+struct scene_builder {
+    ecs_world_t* world;
+    struct scene_build_component* components;
+    struct scene_build_batch* batches;
+    // prefab, parent and component names, entity names are kept with their batch
+    char* names;
+    // values of the entity being read, in the order components appear in it
+    uint8_t* scratch;
+    const char* error;
+};
+
+static uint32_t scene_align(uint32_t offset)
+{
+    return (offset + K_SCENE_DATA_ALIGN - 1) & ~(uint32_t)(K_SCENE_DATA_ALIGN - 1);
+}
+
+static uint32_t scene_build_name(struct scene_builder* b, const char* name)
+{
+    if (name[0] == '\0') {
+        return SCENE_BLOB_NONE;
+    }
+
+    const uint32_t offset = (uint32_t)arrlen(b->names);
+    memcpy(arraddnptr(b->names, strlen(name) + 1), name, strlen(name) + 1);
+    return offset;
+}
+
+static bool scene_build_name_eq(struct scene_builder* b, uint32_t offset, const char* name)
+{
+    if (offset == SCENE_BLOB_NONE) {
+        return name[0] == '\0';
+    }
+    return strcmp(b->names + offset, name) == 0;
+}
+
+// index of the component in b->components, SCENE_BLOB_NONE if the world doesn't know it
+static uint32_t scene_build_component(struct scene_builder* b, const char* path)
+{
+    for (uint32_t c = 0; c < arrlen(b->components); ++c) {
+        if (strcmp(b->components[c].name, path) == 0) {
+            return c;
+        }
+    }
+
+    ecs_entity_t component = ecs_lookup_fullpath(b->world, path);
+    if (!component) {
+        return SCENE_BLOB_NONE;
+    }
+
+    const EcsComponent* info = ecs_get(b->world, component, EcsComponent);
+    struct scene_build_component entry = {
+        .name = ecs_os_strdup(path),
+        .size = (info) ? (uint32_t)info->size : 0,
+        .desc = hmget(scene_descs, component),
+    };
+    arrput(b->components, entry);
+
+    return (uint32_t)arrlen(b->components) - 1;
+}
+
+static struct scene_build_batch* scene_build_batch(
+    struct scene_builder* b,
+    uint32_t flags,
+    const char* prefab,
+    const char* parent,
+    const uint32_t* components,
+    uint32_t component_count)
+{
+    for (int32_t i = 0; i < arrlen(b->batches); ++i) {
+        struct scene_build_batch* batch = &b->batches[i];
+        if (batch->flags == flags && batch->component_count == component_count
+            && scene_build_name_eq(b, batch->prefab_offset, prefab)
+            && scene_build_name_eq(b, batch->parent_offset, parent)
+            && memcmp(batch->components, components, sizeof(uint32_t) * component_count) == 0) {
+            return batch;
+        }
+    }
+
+    struct scene_build_batch batch = {
+        .flags = flags,
+        .prefab_offset = scene_build_name(b, prefab),
+        .parent_offset = scene_build_name(b, parent),
+        .component_count = component_count,
+    };
+    memcpy(batch.components, components, sizeof(uint32_t) * component_count);
+    arrput(b->batches, batch);
+
+    return &arrlast(b->batches);
+}
+
+static void scene_read_string(jsstream* s, char* out)
+{
+    if (jsstream_next(s) == JsEvent_String) {
+        strncpy(out, s->value, K_SCENE_NAME_MAX - 1);
+        out[K_SCENE_NAME_MAX - 1] = '\0';
+    }
+    jsstream_skip(s);
+}
+
+// the reader is positioned on the entity's JsEvent_ObjectBegin
+static bool scene_read_entity(struct scene_builder* b, jsstream* s, uint32_t flags)
+{
+    char name[K_SCENE_NAME_MAX] = {0};
+    char prefab[K_SCENE_NAME_MAX] = {0};
+    char parent[K_SCENE_NAME_MAX] = {0};
+    uint32_t components[K_SCENE_MAX_COLUMNS];
+    uint32_t offsets[K_SCENE_MAX_COLUMNS];
+    uint32_t component_count = 0;
+
+    arrsetlen(b->scratch, 0);
+
+    while (jsstream_next(s) == JsEvent_Key) {
+        if (jsstream_eq(s, "name")) {
+            scene_read_string(s, name);
+            continue;
+        }
+        if (jsstream_eq(s, "prefab")) {
+            scene_read_string(s, prefab);
+            continue;
+        }
+        if (jsstream_eq(s, "parent")) {
+            scene_read_string(s, parent);
+            continue;
+        }
+
+        const bool is_components = jsstream_eq(s, "components");
+        if (jsstream_next(s) != JsEvent_ObjectBegin || !is_components) {
+            jsstream_skip(s);
+            continue;
+        }
+
+        while (jsstream_next(s) == JsEvent_Key) {
+            const uint32_t component = scene_build_component(b, s->value);
+            if (component == SCENE_BLOB_NONE) {
+                ecs_os_err("scene: unknown component %s", s->value);
+                b->error = "unknown component";
+                return false;
+            }
+            // leaves room for the prefab, parent, name and prefab tag columns added when loading
+            if (component_count + 4 == K_SCENE_MAX_COLUMNS) {
+                b->error = "too many components";
+                return false;
+            }
+
+            const struct scene_build_component* info = &b->components[component];
+            const uint32_t offset = (uint32_t)arrlen(b->scratch);
+            memset(arraddnptr(b->scratch, info->size), 0, info->size);
+
+            jsstream_next(s);
+            if (info->desc && info->size > 0) {
+                jsfield field = {.type = JsField_Object, .object = info->desc};
+                jsstream_bind_value(s, &field, b->scratch + offset);
+            } else {
+                jsstream_skip(s);
+            }
+
+            // keep the components sorted so the same set always makes the same batch
+            uint32_t i = component_count;
+            for (; i > 0 && components[i - 1] > component; --i) {
+                components[i] = components[i - 1];
+                offsets[i] = offsets[i - 1];
+            }
+            if (i > 0 && components[i - 1] == component) {
+                b->error = "component listed twice";
+                return false;
+            }
+            components[i] = component;
+            offsets[i] = offset;
+            ++component_count;
+        }
+    }
+
+    if (s->event == JsEvent_Error) {
+        return false;
+    }
+
+    if ((flags & SceneBatch_Prefab) && name[0] == '\0') {
+        b->error = "prefabs need a name";
+        return false;
+    }
+    if (name[0] != '\0') {
+        flags |= SceneBatch_Named;
+    }
+
+    struct scene_build_batch* batch =
+        scene_build_batch(b, flags, prefab, parent, components, component_count);
+    for (uint32_t c = 0; c < component_count; ++c) {
+        const uint32_t size = b->components[components[c]].size;
+        memcpy(arraddnptr(batch->columns[c], size), b->scratch + offsets[c], size);
+    }
+    if (flags & SceneBatch_Named) {
+        memcpy(arraddnptr(batch->names, strlen(name) + 1), name, strlen(name) + 1);
+    }
+    ++batch->entity_count;
+
+    return true;
+}
+
+// b->batches are expected to have the prefabs first
+static tx_result scene_write(struct scene_builder* b, const char* filename)
+{
+    const uint32_t batch_count = (uint32_t)arrlen(b->batches);
+    struct scene_blob_header header = {
+        .magic = SCENE_BLOB_MAGIC,
+        .version = SCENE_BLOB_VERSION,
+        .component_count = (uint32_t)arrlen(b->components),
+        .batch_count = batch_count,
+    };
+
+    struct scene_blob_component* components = NULL;
+    struct scene_blob_batch* batches = NULL;
+    struct scene_blob_column* columns = NULL;
+
+    header.names_size = (uint32_t)arrlen(b->names);
+    for (uint32_t c = 0; c < header.component_count; ++c) {
+        struct scene_blob_component component = {
+            .name_offset = header.names_size,
+            .size = b->components[c].size,
+        };
+        arrput(components, component);
+        header.names_size += (uint32_t)strlen(b->components[c].name) + 1;
+    }
+
+    for (uint32_t i = 0; i < batch_count; ++i) {
+        const struct scene_build_batch* batch = &b->batches[i];
+        struct scene_blob_batch entry = {
+            .flags = batch->flags,
+            .prefab_offset = batch->prefab_offset,
+            .parent_offset = batch->parent_offset,
+            .names_offset = SCENE_BLOB_NONE,
+            .entity_count = batch->entity_count,
+            .first_column = header.column_count,
+            .column_count = batch->component_count,
+        };
+        if (batch->flags & SceneBatch_Named) {
+            entry.names_offset = header.names_size;
+            header.names_size += (uint32_t)arrlen(batch->names);
+        }
+        arrput(batches, entry);
+
+        for (uint32_t c = 0; c < batch->component_count; ++c) {
+            struct scene_blob_column column = {
+                .component = batch->components[c],
+                .data_offset = SCENE_BLOB_NONE,
+            };
+            const uint32_t size = (uint32_t)arrlen(batch->columns[c]);
+            if (size > 0) {
+                header.data_size = scene_align(header.data_size);
+                column.data_offset = header.data_size;
+                header.data_size += size;
+            }
+            arrput(columns, column);
+            ++header.column_count;
+        }
+    }
+
+    // pad the names so the columns are aligned in the file too
+    const uint32_t tables_size = sizeof(header)
+                                 + sizeof(struct scene_blob_component) * header.component_count
+                                 + sizeof(struct scene_blob_batch) * header.batch_count
+                                 + sizeof(struct scene_blob_column) * header.column_count;
+    const uint32_t names_padding =
+        scene_align(tables_size + header.names_size) - (tables_size + header.names_size);
+    header.names_size += names_padding;
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        arrfree(components);
+        arrfree(batches);
+        arrfree(columns);
+        return TX_FILE_ERROR;
+    }
+
+    static const uint8_t k_padding[K_SCENE_DATA_ALIGN] = {0};
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(components, sizeof(*components), header.component_count, file);
+    fwrite(batches, sizeof(*batches), header.batch_count, file);
+    fwrite(columns, sizeof(*columns), header.column_count, file);
+
+    if (b->names) {
+        fwrite(b->names, 1, arrlen(b->names), file);
+    }
+    for (uint32_t c = 0; c < header.component_count; ++c) {
+        fwrite(b->components[c].name, strlen(b->components[c].name) + 1, 1, file);
+    }
+    for (uint32_t i = 0; i < batch_count; ++i) {
+        if (b->batches[i].names) {
+            fwrite(b->batches[i].names, 1, arrlen(b->batches[i].names), file);
+        }
+    }
+    fwrite(k_padding, 1, names_padding, file);
+
+    uint32_t data_written = 0;
+    for (uint32_t i = 0; i < batch_count; ++i) {
+        const struct scene_build_batch* batch = &b->batches[i];
+        for (uint32_t c = 0; c < batch->component_count; ++c) {
+            const uint32_t size = (uint32_t)arrlen(batch->columns[c]);
+            if (size == 0) {
+                continue;
+            }
+            const uint32_t aligned = scene_align(data_written);
+            fwrite(k_padding, 1, aligned - data_written, file);
+            fwrite(batch->columns[c], 1, size, file);
+            data_written = aligned + size;
+        }
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    arrfree(components);
+    arrfree(batches);
+    arrfree(columns);
+
+    return (ok) ? TX_SUCCESS : TX_FILE_ERROR;
+}
+
+static void scene_builder_free(struct scene_builder* b)
+{
+    for (int32_t c = 0; c < arrlen(b->components); ++c) {
+        ecs_os_free(b->components[c].name);
+    }
+    for (int32_t i = 0; i < arrlen(b->batches); ++i) {
+        for (uint32_t c = 0; c < b->batches[i].component_count; ++c) {
+            arrfree(b->batches[i].columns[c]);
+        }
+        arrfree(b->batches[i].names);
+    }
+    arrfree(b->components);
+    arrfree(b->batches);
+    arrfree(b->names);
+    arrfree(b->scratch);
+}
+
+tx_result scene_compile(ecs_world_t* world, const char* json_filename, const char* scn_filename)
+{
+    jsstream* s = malloc(sizeof(jsstream));
+    tx_result result = jsstream_open(s, json_filename);
+    if (result != TX_SUCCESS) {
+        free(s);
+        return result;
+    }
+
+    struct scene_builder b = {.world = world};
+
+    if (jsstream_next(s) == JsEvent_ObjectBegin) {
+        while (!b.error && jsstream_next(s) == JsEvent_Key) {
+            const bool is_prefabs = jsstream_eq(s, "prefabs");
+            const bool is_entities = jsstream_eq(s, "entities");
+
+            if (jsstream_next(s) != JsEvent_ArrayBegin || !(is_prefabs || is_entities)) {
+                jsstream_skip(s);
+                continue;
+            }
+
+            const uint32_t flags = (is_prefabs) ? SceneBatch_Prefab : 0;
+            while (!b.error && jsstream_next(s) == JsEvent_ObjectBegin) {
+                if (!scene_read_entity(&b, s, flags) && !b.error) {
+                    b.error = s->error;
+                }
+            }
+        }
+    }
+
+    if (s->event == JsEvent_Error && !b.error) {
+        b.error = s->error;
+    }
+
+    if (b.error) {
+        ecs_os_err("%s: %s at byte %zu", json_filename, b.error, s->offset + s->pos);
+        result = TX_PARSE_ERROR;
+    } else {
+        // stable partition, prefabs go first so they exist before their instances are created
+        struct scene_build_batch* ordered = NULL;
+        for (int32_t pass = 0; pass < 2; ++pass) {
+            for (int32_t i = 0; i < arrlen(b.batches); ++i) {
+                if (((b.batches[i].flags & SceneBatch_Prefab) != 0) == (pass == 0)) {
+                    arrput(ordered, b.batches[i]);
+                }
+            }
+        }
+        arrfree(b.batches);
+        b.batches = ordered;
+
+        result = scene_write(&b, scn_filename);
+    }
+
+    jsstream_close(s);
+    free(s);
+    scene_builder_free(&b);
+
+    return result;
+}
+
+//// LOADING
+
+tx_result scene_blob_parse(const char* data, size_t len, struct scene_blob* blob)
+{
+    TX_ASSERT(blob);
+    memset(blob, 0, sizeof(struct scene_blob));
+
+    struct scene_blob_header header;
+    if (len < sizeof(header)) {
+        return TX_PARSE_ERROR;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    const size_t components_offset = sizeof(header);
+    const size_t batches_offset =
+        components_offset + sizeof(struct scene_blob_component) * header.component_count;
+    const size_t columns_offset =
+        batches_offset + sizeof(struct scene_blob_batch) * header.batch_count;
+    const size_t names_offset =
+        columns_offset + sizeof(struct scene_blob_column) * header.column_count;
+    const size_t data_offset = names_offset + header.names_size;
+
+    if (header.magic != SCENE_BLOB_MAGIC || header.version != SCENE_BLOB_VERSION
+        || len < data_offset + header.data_size) {
+        return TX_PARSE_ERROR;
+    }
+
+    const struct scene_blob_component* components =
+        (const struct scene_blob_component*)(data + components_offset);
+    const struct scene_blob_batch* batches =
+        (const struct scene_blob_batch*)(data + batches_offset);
+    const struct scene_blob_column* columns =
+        (const struct scene_blob_column*)(data + columns_offset);
+
+    for (uint32_t c = 0; c < header.component_count; ++c) {
+        if (components[c].name_offset >= header.names_size) {
+            return TX_PARSE_ERROR;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.batch_count; ++i) {
+        const struct scene_blob_batch* batch = &batches[i];
+        if (batch->first_column + batch->column_count > header.column_count
+            || batch->column_count + 4 > K_SCENE_MAX_COLUMNS
+            || (batch->prefab_offset != SCENE_BLOB_NONE
+                && batch->prefab_offset >= header.names_size)
+            || (batch->parent_offset != SCENE_BLOB_NONE
+                && batch->parent_offset >= header.names_size)
+            || ((batch->flags & SceneBatch_Named) && batch->names_offset >= header.names_size)) {
+            return TX_PARSE_ERROR;
+        }
+
+        for (uint32_t c = batch->first_column; c < batch->first_column + batch->column_count; ++c) {
+            if (columns[c].component >= header.component_count) {
+                return TX_PARSE_ERROR;
+            }
+            const uint64_t size =
+                (uint64_t)components[columns[c].component].size * batch->entity_count;
+            if (columns[c].data_offset != SCENE_BLOB_NONE
+                && columns[c].data_offset + size > header.data_size) {
+                return TX_PARSE_ERROR;
+            }
+        }
+    }
+
+    // names are only ever padded with NULs, the last one is terminated if the final byte is
+    if (header.names_size && data[names_offset + header.names_size - 1] != '\0') {
+        return TX_PARSE_ERROR;
+    }
+
+    blob->header = header;
+    blob->components = components;
+    blob->batches = batches;
+    blob->columns = columns;
+    blob->names = data + names_offset;
+    blob->data = (const uint8_t*)(data + data_offset);
+
+    return TX_SUCCESS;
+}
+
+tx_result scene_blob_load(const char* filename, struct scene_blob* blob)
+{
+    file_view file;
+    tx_result result = file_map(filename, &file);
+    if (result != TX_SUCCESS) {
+        return result;
+    }
+
+    result = scene_blob_parse(file.data, file.len, blob);
+    if (result != TX_SUCCESS) {
+        file_unmap(&file);
+        return result;
+    }
+
+    blob->file = file;
+    return TX_SUCCESS;
+}
+
+void scene_blob_free(struct scene_blob* blob)
+{
+    file_unmap(&blob->file);
+    memset(blob, 0, sizeof(struct scene_blob));
+}
+
+static ecs_entity_t scene_lookup(ecs_world_t* world, const struct scene_blob* blob, uint32_t offset)
+{
+    const char* name = blob->names + offset;
+    ecs_entity_t e = ecs_lookup_fullpath(world, name);
+    if (!e) {
+        ecs_os_err("scene: no entity named %s", name);
+    }
+    return e;
+}
+
+tx_result scene_instantiate(ecs_world_t* world, const struct scene_blob* blob)
+{
+    const struct scene_blob_header* header = &blob->header;
+
+    ecs_entity_t* components = NULL;
+    arrsetlen(components, header->component_count);
+    for (uint32_t c = 0; c < header->component_count; ++c) {
+        const char* name = blob->names + blob->components[c].name_offset;
+        components[c] = ecs_lookup_fullpath(world, name);
+
+        // the layout of components can change after a scene is compiled, a size mismatch is
+        // the best that can be checked for
+        const EcsComponent* info = ecs_get(world, components[c], EcsComponent);
+        const uint32_t size = (info) ? (uint32_t)info->size : 0;
+        if (!components[c] || size != blob->components[c].size) {
+            ecs_os_err("scene: component %s is missing or changed size", name);
+            arrfree(components);
+            return TX_INVALID;
+        }
+    }
+
+    EcsName* names = NULL;
+    tx_result result = TX_SUCCESS;
+
+    for (uint32_t i = 0; i < header->batch_count && result == TX_SUCCESS; ++i) {
+        const struct scene_blob_batch* batch = &blob->batches[i];
+
+        scene_column columns[K_SCENE_MAX_COLUMNS];
+        int32_t column_count = 0;
+
+        for (uint32_t c = 0; c < batch->column_count; ++c) {
+            const struct scene_blob_column* column = &blob->columns[batch->first_column + c];
+            columns[column_count++] = (scene_column){
+                .id = components[column->component],
+                .size = (int32_t)blob->components[column->component].size,
+                .data = (column->data_offset != SCENE_BLOB_NONE)
+                            ? blob->data + column->data_offset
+                            : NULL,
+            };
+        }
+
+        if (batch->prefab_offset != SCENE_BLOB_NONE) {
+            ecs_entity_t prefab = scene_lookup(world, blob, batch->prefab_offset);
+            columns[column_count++] = (scene_column){.id = ecs_pair(EcsIsA, prefab)};
+            result = (prefab) ? result : TX_INVALID;
+        }
+        if (batch->parent_offset != SCENE_BLOB_NONE) {
+            ecs_entity_t parent = scene_lookup(world, blob, batch->parent_offset);
+            columns[column_count++] = (scene_column){.id = ecs_pair(EcsChildOf, parent)};
+            result = (parent) ? result : TX_INVALID;
+        }
+        if (batch->flags & SceneBatch_Prefab) {
+            columns[column_count++] = (scene_column){.id = EcsPrefab};
+        }
+        if (batch->flags & SceneBatch_Named) {
+            // the name is copied into each entity so it doesn't reference the file
+            arrsetlen(names, batch->entity_count);
+            const char* name = blob->names + batch->names_offset;
+            for (uint32_t e = 0; e < batch->entity_count; ++e) {
+                names[e] = (EcsName){.value = name, .alloc_value = (char*)name};
+                name += strlen(name) + 1;
+            }
+            columns[column_count++] = (scene_column){
+                .id = ecs_id(EcsName),
+                .size = sizeof(EcsName),
+                .data = names,
+            };
+        }
+
+        if (result == TX_SUCCESS) {
+            scene_spawn(world, columns, column_count, (int32_t)batch->entity_count);
+        }
+    }
+
+    arrfree(names);
+    arrfree(components);
+
+    return result;
+}
+
+tx_result scene_load(ecs_world_t* world, const char* json_filename)
+{
+    char scn_filename[K_SCENE_NAME_MAX];
+    const char* ext = strrchr(json_filename, '.');
+    const int32_t stem_len = (ext) ? (int32_t)(ext - json_filename) : (int32_t)strlen(json_filename);
+    snprintf(scn_filename, sizeof(scn_filename), "%.*s.scn", stem_len, json_filename);
+
+    const int64_t json_time = file_mtime(json_filename);
+    if (json_time && json_time >= file_mtime(scn_filename)) {
+        tx_result result = scene_compile(world, json_filename, scn_filename);
+        if (result != TX_SUCCESS) {
+            return result;
+        }
+    }
+
+    struct scene_blob blob;
+    tx_result result = scene_blob_load(scn_filename, &blob);
+    if (result != TX_SUCCESS) {
+        ecs_os_err("failed to load %s", scn_filename);
+        return result;
+    }
+
+    result = scene_instantiate(world, &blob);
+    scene_blob_free(&blob);
+
+    return result;
+}
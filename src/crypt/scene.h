@@ -0,0 +1,125 @@
+// scene.h - Scene Files
+// Levels are written as json and compiled into a binary .scn next to the source, scene_load
+// recompiles whenever the json is newer. Entities that share a prefab, parent and set of
+// components are grouped into a batch when compiling and every batch is created in one bulk
+// operation, straight into its final archetype with the component columns copied from the file.
+//
+// source:
+//   {
+//       "prefabs": [entity, ...],
+//       "entities": [entity, ...]
+//   }
+//
+//   entity:
+//   {
+//       "name": "InvaderPrefab",                 optional
+//       "prefab": "InvaderPrefab",               optional, instance of a prefab in this file
+//       "parent": "InvaderRoot",                 optional, any named entity in the world
+//       "components": {
+//           "game.comp.Position": { "x": 0, "y": 0 },
+//           "Hostile": {}                          tags and components without fields
+//       }
+//   }
+//
+// Components are bound with jsfield descriptors registered through scene_register_component.
+// Anything without a descriptor is added without a value.
+//
+// compiled layout:
+//   struct scene_blob_header
+//   struct scene_blob_component[component_count]
+//   struct scene_blob_batch[batch_count], prefab batches first
+//   struct scene_blob_column[column_count]
+//   names: names_size bytes of NUL terminated strings
+//   data: data_size bytes of component columns, entity_count * size bytes each
+
+#pragma once
+
+#include "flecs.h"
+#include "futils.h"
+#include "jsonutil.h"
+#include "tx_types.h"
+
+enum {
+    SCENE_BLOB_MAGIC = 0x4e435343, // 'CSCN'
+    SCENE_BLOB_VERSION = 1,
+    SCENE_BLOB_NONE = 0xffffffff,
+    // most components a batch can have, prefab and parent pairs included
+    K_SCENE_MAX_COLUMNS = 32,
+};
+
+typedef enum scene_batch_flags {
+    SceneBatch_Prefab = 1 << 0,
+    // names holds entity_count names back to back
+    SceneBatch_Named = 1 << 1,
+} scene_batch_flags;
+
+struct scene_blob_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t component_count;
+    uint32_t batch_count;
+    uint32_t column_count;
+    uint32_t names_size;
+    uint32_t data_size;
+};
+
+struct scene_blob_component {
+    uint32_t name_offset; // full path
+    uint32_t size;        // 0 for tags
+};
+
+struct scene_blob_batch {
+    uint32_t flags;
+    uint32_t prefab_offset; // name of the prefab or SCENE_BLOB_NONE
+    uint32_t parent_offset; // name of the parent or SCENE_BLOB_NONE
+    uint32_t names_offset;  // first name when SceneBatch_Named
+    uint32_t entity_count;
+    uint32_t first_column;
+    uint32_t column_count;
+};
+
+struct scene_blob_column {
+    uint32_t component;
+    uint32_t data_offset; // SCENE_BLOB_NONE for tags
+};
+
+struct scene_blob {
+    struct scene_blob_header header;
+    const struct scene_blob_component* components;
+    const struct scene_blob_batch* batches;
+    const struct scene_blob_column* columns;
+    const char* names;
+    const uint8_t* data;
+    file_view file;
+};
+
+// One column of entities to spawn, data holds count values of size bytes or NULL for tags and
+// pairs without a value.
+typedef struct scene_column {
+    ecs_id_t id;
+    int32_t size;
+    const void* data;
+} scene_column;
+
+// Descriptor used to read the component from scene files, desc must outlive the world.
+void scene_register_component(ecs_world_t* world, ecs_entity_t component, jsobject_desc* desc);
+#define SCENE_COMPONENT(world, type, desc) scene_register_component(world, ecs_id(type), desc)
+// Shared descriptor for vec2 members, { "x": 0, "y": 0 }
+extern jsobject_desc scene_vec2_desc;
+
+// Creates count entities with every column in a single table operation and returns their ids,
+// which stay valid until the next entity is created. Only a world that isn't deferred gets the
+// single table operation, systems always run deferred and there the entities are created empty
+// and every value is set on its own when the stage is merged.
+const ecs_entity_t* scene_spawn(
+    ecs_world_t* world, const scene_column* columns, int32_t column_count, int32_t count);
+
+// Entity named by symbol (a full path), looked up once and cached until the entity is deleted.
+ecs_entity_t scene_lookup_symbol(ecs_world_t* world, str_id symbol);
+
+tx_result scene_compile(ecs_world_t* world, const char* json_filename, const char* scn_filename);
+tx_result scene_blob_load(const char* filename, struct scene_blob* blob);
+void scene_blob_free(struct scene_blob* blob);
+tx_result scene_instantiate(ecs_world_t* world, const struct scene_blob* blob);
+// Loads path.json through path.scn, compiling it first if it's missing or out of date.
+tx_result scene_load(ecs_world_t* world, const char* json_filename);
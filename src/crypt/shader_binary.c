@@ -0,0 +1,168 @@
+#include "shader_binary.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { K_MAX_DEFERRED_SHADERS = 2, K_DRIVER_MAX = 256 };
+
+static struct {
+    bool active;
+    const shader_binary* binary;
+    bool loaded;
+    shader_binary linked;
+#if !CRYPT_HEADLESS
+    // compiles skipped while a binary is pending
+    GLuint deferred[K_MAX_DEFERRED_SHADERS];
+    int32_t deferred_count;
+#endif
+    int32_t supported; // 0 unknown, 1 yes, -1 no
+    char driver[K_DRIVER_MAX];
+} state;
+
+#if CRYPT_HEADLESS
+
+bool shader_binary_supported(void)
+{
+    return false;
+}
+
+const char* shader_binary_driver(void)
+{
+    return "";
+}
+
+#else
+
+bool shader_binary_supported(void)
+{
+    if (state.supported == 0) {
+        GLint formats = 0;
+        if (glProgramBinary && glGetProgramBinary && glProgramParameteri) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        state.supported = (formats > 0) ? 1 : -1;
+    }
+    return state.supported > 0;
+}
+
+const char* shader_binary_driver(void)
+{
+    if (!state.driver[0]) {
+        snprintf(
+            state.driver,
+            sizeof(state.driver),
+            "%s | %s | %s",
+            (const char*)glGetString(GL_VENDOR),
+            (const char*)glGetString(GL_RENDERER),
+            (const char*)glGetString(GL_VERSION));
+    }
+    return state.driver;
+}
+
+static bool is_deferred(GLuint shader)
+{
+    for (int32_t i = 0; i < state.deferred_count; ++i) {
+        if (state.deferred[i] == shader) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void shader_binary_compile_shader(GLuint shader)
+{
+    if (state.binary && state.deferred_count < K_MAX_DEFERRED_SHADERS) {
+        state.deferred[state.deferred_count++] = shader;
+        return;
+    }
+    glCompileShader(shader);
+}
+
+void shader_binary_get_shaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+    // a deferred shader reports success, a real compile error shows up when it's linked instead
+    if (is_deferred(shader) && (pname == GL_COMPILE_STATUS || pname == GL_INFO_LOG_LENGTH)) {
+        *params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+        return;
+    }
+    glGetShaderiv(shader, pname, params);
+}
+
+void shader_binary_link_program(GLuint program)
+{
+    if (!state.active) {
+        glLinkProgram(program);
+        return;
+    }
+
+    GLint linked = GL_FALSE;
+    if (state.binary) {
+        glProgramBinary(
+            program, (GLenum)state.binary->format, state.binary->data, state.binary->size);
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked) {
+            state.loaded = true;
+            return;
+        }
+
+        // the binary is from another driver version, or the driver dropped support for its format
+        while (glGetError() != GL_NO_ERROR) {
+        }
+        for (int32_t i = 0; i < state.deferred_count; ++i) {
+            glCompileShader(state.deferred[i]);
+        }
+        state.deferred_count = 0;
+    }
+
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+
+    GLint size = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked) {
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    }
+    if (size > 0) {
+        GLenum format = 0;
+        state.linked.data = malloc(size);
+        glGetProgramBinary(program, size, &state.linked.size, &format, state.linked.data);
+        state.linked.format = (uint32_t)format;
+    }
+}
+
+#endif
+
+void shader_binary_begin(const shader_binary* binary)
+{
+    TX_ASSERT(!state.active);
+
+    state.active = shader_binary_supported();
+    state.binary = (state.active) ? binary : NULL;
+    state.loaded = false;
+    state.linked = (shader_binary){0};
+#if !CRYPT_HEADLESS
+    state.deferred_count = 0;
+#endif
+}
+
+bool shader_binary_end(shader_binary* out)
+{
+    *out = state.linked;
+    const bool loaded = state.loaded;
+
+    state.active = false;
+    state.binary = NULL;
+    state.loaded = false;
+    state.linked = (shader_binary){0};
+#if !CRYPT_HEADLESS
+    state.deferred_count = 0;
+#endif
+    return loaded;
+}
+
+void shader_binary_free(shader_binary* binary)
+{
+    free(binary->data);
+    *binary = (shader_binary){0};
+}
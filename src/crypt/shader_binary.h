@@ -0,0 +1,38 @@
+// shader_binary.h - GL Program Binaries
+// sokol only builds GL programs from source. impl.c routes the glCompileShader, glGetShaderiv and
+// glLinkProgram calls of sokol's GL backend through the hooks below, so a program can be loaded
+// from a binary saved by an earlier run (glProgramBinary) and the binary of a program linked from
+// source can be read back. When the driver rejects the binary the shaders are compiled after all.
+
+#pragma once
+
+#include "tx_types.h"
+
+#if !CRYPT_HEADLESS
+#include <GL/gl3w.h>
+#endif
+
+typedef struct shader_binary {
+    uint32_t format;
+    int32_t size;
+    void* data;
+} shader_binary;
+
+// Whether the driver can save and load program binaries, needs the GL context.
+bool shader_binary_supported(void);
+// Vendor, renderer and version of the driver, a binary only loads on the driver that made it.
+const char* shader_binary_driver(void);
+
+// Applies to the next sg_make_shader. With a binary the program is loaded from it instead of
+// compiled, pass NULL to only read back the binary of the program.
+void shader_binary_begin(const shader_binary* binary);
+// Returns whether the program was loaded from the binary. Otherwise the binary of the program that
+// was linked from source goes to out (size 0 if there is none), free it with shader_binary_free.
+bool shader_binary_end(shader_binary* out);
+void shader_binary_free(shader_binary* binary);
+
+#if !CRYPT_HEADLESS
+void shader_binary_compile_shader(GLuint shader);
+void shader_binary_get_shaderiv(GLuint shader, GLenum pname, GLint* params);
+void shader_binary_link_program(GLuint program);
+#endif
@@ -0,0 +1,266 @@
+#include "shader_cache.h"
+#include "futils.h"
+#include "hash.h"
+#include "shader_binary.h"
+#include "stb_ds.h"
+
+#include <stdio.h>
+#include <string.h>
+
+enum {
+    K_SHADER_BINARY_MAGIC = 0x4e424853, // 'SHBN'
+    K_SHADER_BINARY_VERSION = 1,
+};
+
+// assets/shaders/<key>.glbin, followed by the driver string, the sources and the program binary
+struct shader_binary_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t driver_size;
+    uint32_t sources_size;
+    uint32_t format;
+    uint32_t binary_size;
+};
+
+struct shader_cache_entry {
+    uint32_t key;
+    // the preprocessed sources, compared on a key hit so a hash collision can't share a shader
+    char* sources;
+    sg_shader shader;
+    int32_t refs;
+};
+
+struct shader_cache {
+    struct shader_cache_entry* entries;
+    int32_t hits;
+    int32_t binary_loads;
+    int32_t misses;
+};
+
+static struct shader_cache cache = {0};
+
+static void append_chars(char** out, const char* chars, size_t len)
+{
+    size_t at = arrlen(*out);
+    arrsetlen(*out, at + len);
+    memcpy(*out + at, chars, len);
+}
+
+// Appends source to out with the defines inserted right after the #version directive, which has to
+// stay the first line of a glsl shader.
+static void preprocess_source(
+    char** out, const char* source, const char* const* defines, int32_t define_count)
+{
+    const char* body = source;
+    if (strncmp(source, "#version", 8) == 0) {
+        const char* eol = strchr(source, '\n');
+        body = (eol) ? eol + 1 : source + strlen(source);
+        append_chars(out, source, body - source);
+    }
+
+    for (int32_t i = 0; i < define_count; ++i) {
+        append_chars(out, "#define ", 8);
+        append_chars(out, defines[i], strlen(defines[i]));
+        arrput(*out, '\n');
+    }
+
+    append_chars(out, body, strlen(body));
+    arrput(*out, '\0');
+}
+
+static void shader_binary_path(uint32_t key, char* path, size_t size)
+{
+    snprintf(path, size, "assets/shaders/%08x.glbin", key);
+}
+
+// The binary saved for these sources, only if it was made by the running driver. binary points into
+// file, which has to stay mapped until the shader is made.
+static bool shader_binary_read(
+    uint32_t key, const char* sources, size_t sources_size, file_view* file, shader_binary* binary)
+{
+    char path[64];
+    shader_binary_path(key, path, sizeof(path));
+    if (file_map(path, file) != TX_SUCCESS) {
+        return false;
+    }
+
+    const char* driver = shader_binary_driver();
+    const size_t driver_size = strlen(driver);
+
+    struct shader_binary_header header;
+    if (file->len < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, file->data, sizeof(header));
+
+    const char* stored_driver = file->data + sizeof(header);
+    const char* stored_sources = stored_driver + header.driver_size;
+    const uint64_t size = (uint64_t)sizeof(header) + header.driver_size + header.sources_size
+                          + header.binary_size;
+
+    if (header.magic != K_SHADER_BINARY_MAGIC || header.version != K_SHADER_BINARY_VERSION
+        || size != file->len || header.driver_size != driver_size
+        || header.sources_size != sources_size
+        || memcmp(stored_driver, driver, driver_size) != 0
+        || memcmp(stored_sources, sources, sources_size) != 0) {
+        return false;
+    }
+
+    *binary = (shader_binary){
+        .format = header.format,
+        .size = (int32_t)header.binary_size,
+        .data = (void*)(stored_sources + header.sources_size),
+    };
+    return true;
+}
+
+static void shader_binary_write(
+    uint32_t key, const char* sources, size_t sources_size, const shader_binary* binary)
+{
+    char path[64];
+    shader_binary_path(key, path, sizeof(path));
+
+    const char* driver = shader_binary_driver();
+    struct shader_binary_header header = {
+        .magic = K_SHADER_BINARY_MAGIC,
+        .version = K_SHADER_BINARY_VERSION,
+        .driver_size = (uint32_t)strlen(driver),
+        .sources_size = (uint32_t)sources_size,
+        .format = binary->format,
+        .binary_size = (uint32_t)binary->size,
+    };
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return;
+    }
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(driver, 1, header.driver_size, file);
+    fwrite(sources, 1, sources_size, file);
+    fwrite(binary->data, 1, binary->size, file);
+    fclose(file);
+}
+
+sg_shader shader_cache_load(
+    const char* vs_filename,
+    const char* fs_filename,
+    const char* const* defines,
+    int32_t define_count,
+    sg_shader_desc desc)
+{
+    file_view vs_file, fs_file;
+
+    enum tx_result vs_result = file_map(vs_filename, &vs_file);
+    enum tx_result fs_result = file_map(fs_filename, &fs_file);
+
+    if (vs_result != TX_SUCCESS || fs_result != TX_SUCCESS) {
+        file_unmap(&vs_file);
+        file_unmap(&fs_file);
+        return (sg_shader){SG_INVALID_ID};
+    }
+
+    // both stages go in one buffer so the key covers the whole variant
+    char* sources = NULL;
+    preprocess_source(&sources, vs_file.data, defines, define_count);
+    size_t fs_offset = arrlen(sources);
+    preprocess_source(&sources, fs_file.data, defines, define_count);
+
+    file_unmap(&vs_file);
+    file_unmap(&fs_file);
+
+    const size_t sources_size = arrlen(sources);
+    uint32_t key = hash_data(sources, sources_size);
+
+    for (int32_t i = 0; i < arrlen(cache.entries); ++i) {
+        struct shader_cache_entry* entry = &cache.entries[i];
+        if (entry->key == key && arrlen(entry->sources) == sources_size
+            && memcmp(entry->sources, sources, sources_size) == 0) {
+            entry->refs++;
+            cache.hits++;
+            arrfree(sources);
+            return entry->shader;
+        }
+    }
+
+    file_view binary_file = {0};
+    shader_binary stored = {0};
+    const bool has_binary =
+        shader_binary_supported()
+        && shader_binary_read(key, sources, sources_size, &binary_file, &stored);
+
+    desc.vs.source = sources;
+    desc.fs.source = sources + fs_offset;
+
+    shader_binary_begin((has_binary) ? &stored : NULL);
+    sg_shader shader = sg_make_shader(&desc);
+    shader_binary linked;
+    const bool from_binary = shader_binary_end(&linked);
+
+    file_unmap(&binary_file);
+
+    if (from_binary) {
+        cache.binary_loads++;
+    } else {
+        cache.misses++;
+    }
+
+    if (sg_query_shader_state(shader) == SG_RESOURCESTATE_VALID) {
+        if (linked.size > 0) {
+            shader_binary_write(key, sources, sources_size, &linked);
+        }
+        arrput(
+            cache.entries,
+            ((struct shader_cache_entry){
+                .key = key,
+                .sources = sources,
+                .shader = shader,
+                .refs = 1,
+            }));
+    } else {
+        arrfree(sources);
+    }
+    shader_binary_free(&linked);
+
+    return shader;
+}
+
+void shader_cache_release(sg_shader shader)
+{
+    for (int32_t i = 0; i < arrlen(cache.entries); ++i) {
+        struct shader_cache_entry* entry = &cache.entries[i];
+        if (entry->shader.id == shader.id) {
+            if (--entry->refs == 0) {
+                sg_destroy_shader(entry->shader);
+                arrfree(entry->sources);
+                arrdelswap(cache.entries, i);
+            }
+            return;
+        }
+    }
+
+    // shaders that never made it into the cache
+    if (shader.id != SG_INVALID_ID) {
+        sg_destroy_shader(shader);
+    }
+}
+
+void shader_cache_clear(void)
+{
+    for (int32_t i = 0; i < arrlen(cache.entries); ++i) {
+        sg_destroy_shader(cache.entries[i].shader);
+        arrfree(cache.entries[i].sources);
+    }
+    arrfree(cache.entries);
+    cache.hits = 0;
+    cache.binary_loads = 0;
+    cache.misses = 0;
+}
+
+void shader_cache_get_stats(
+    int32_t* entries, int32_t* hits, int32_t* binary_loads, int32_t* misses)
+{
+    *entries = (int32_t)arrlen(cache.entries);
+    *hits = cache.hits;
+    *binary_loads = cache.binary_loads;
+    *misses = cache.misses;
+}
@@ -0,0 +1,31 @@
+// shader_cache.h - Shader Variant Cache
+// Shaders are built from a pair of source files plus a list of #defines that select a variant.
+// The defines are injected after the #version line and the resulting sources are hashed, any
+// request that produces the same sources shares the already compiled sg_shader.
+//
+// Compiled programs are also saved to assets/shaders/<hash>.glbin together with their sources and
+// the driver string. The next run loads the program binary instead of compiling when both match,
+// see shader_binary.h.
+//
+// Not thread safe, once the sprite renderer's render thread runs it's the only one using the cache.
+
+#pragma once
+
+#include "sokol_gfx.h"
+#include "tx_types.h"
+
+// Returns the shader for the variant, desc only needs the uniform/image layout, the sources are
+// filled in from the files. A shader that failed to compile is returned as-is (and isn't cached)
+// so the caller can check its state and destroy it.
+sg_shader shader_cache_load(
+    const char* vs_filename,
+    const char* fs_filename,
+    const char* const* defines,
+    int32_t define_count,
+    sg_shader_desc desc);
+void shader_cache_release(sg_shader shader);
+// destroys every cached shader
+void shader_cache_clear(void);
+// hits are shared variants, binary_loads programs loaded from disk and misses compiles
+void shader_cache_get_stats(
+    int32_t* entries, int32_t* hits, int32_t* binary_loads, int32_t* misses);
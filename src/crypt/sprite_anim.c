@@ -0,0 +1,201 @@
+#include "sprite_anim.h"
+#include "futils.h"
+#include "hash.h"
+#include "jsonutil.h"
+#include "stb_ds.h"
+#include "tx_math.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static struct sprite_anim_clip* clips = NULL;
+static struct sprite_anim_frame* frames = NULL;
+
+// clips look like:
+// { "name": "walk", "fps": 8, "loop": "loop" | "once" | "ping_pong", "width": 1, "height": 1,
+//   "frames": [0, 1, 2] }
+typedef struct clip_json {
+    char name[64];
+    float fps;
+    int loop;
+    int width;
+    int height;
+    int frames;
+} clip_json;
+
+// indexed by sprite_anim_loop
+static const char* const loop_names[] = {"loop", "once", "ping_pong"};
+
+static jsfield clip_fields[] = {
+    JSFIELD(JsField_String, clip_json, name),
+    JSFIELD(JsField_Float, clip_json, fps),
+    JSFIELD_ENUM(clip_json, loop, loop_names),
+    JSFIELD(JsField_Int, clip_json, width),
+    JSFIELD(JsField_Int, clip_json, height),
+    JSFIELD(JsField_Token, clip_json, frames),
+};
+static jsobject_desc clip_desc = JSOBJECT(clip_fields);
+
+// Clips are referred to by their index in the file, one that can't be loaded fails the whole table
+// rather than shifting the ids of every clip after it.
+static tx_result sprite_anim_load_clip(const char* js, jsmntok_t* tokens, int clip_id)
+{
+    clip_json clip = {
+        .loop = SpriteAnimLoop_Loop,
+        .width = 1,
+        .height = 1,
+        .frames = -1,
+    };
+    jsbind(js, tokens, clip_id, &clip_desc, &clip);
+
+    const char* name = clip.name;
+    const sprite_anim_loop loop = (sprite_anim_loop)clip.loop;
+    const float fps = (clip.fps > 0.0f) ? clip.fps : 1.0f;
+    const uint8_t width = (uint8_t)clip.width;
+    const uint8_t height = (uint8_t)clip.height;
+
+    const int frames_id = clip.frames;
+    if (frames_id < 0 || tokens[frames_id].type != JSMN_ARRAY || tokens[frames_id].size == 0) {
+        return TX_PARSE_ERROR;
+    }
+
+    int32_t first_frame = (int32_t)arrlen(frames);
+
+    int frame_tok = frames_id + 1;
+    for (int i = 0; i < tokens[frames_id].size; ++i, frame_tok = jsskip(tokens, frame_tok)) {
+        arrput(
+            frames,
+            ((struct sprite_anim_frame){
+                .sprite_id = (uint16_t)jstoi_or(js, tokens[frame_tok], 0),
+                .width = width,
+                .height = height,
+            }));
+    }
+
+    int32_t frame_count = (int32_t)arrlen(frames) - first_frame;
+
+    // unroll the return trip so ping pong clips can loop like any other clip
+    if (loop == SpriteAnimLoop_PingPong) {
+        for (int32_t i = frame_count - 2; i > 0; --i) {
+            arrput(frames, frames[first_frame + i]);
+        }
+        frame_count = (int32_t)arrlen(frames) - first_frame;
+    }
+
+    arrput(
+        clips,
+        ((struct sprite_anim_clip){
+            .name = str_id_store(name),
+            .loop = loop,
+            .fps = fps,
+            .duration = (loop == SpriteAnimLoop_Once) ? FLT_MAX : frame_count / fps,
+            .last_step = (float)(frame_count - 1),
+            .first_frame = first_frame,
+            .frame_count = frame_count,
+        }));
+
+    return TX_SUCCESS;
+}
+
+tx_result sprite_anim_db_load(const char* filename)
+{
+    file_view file;
+    tx_result result = file_map(filename, &file);
+
+    if (result != TX_SUCCESS) {
+        return result;
+    }
+
+    const char* js = file.data;
+    size_t len = file.len;
+
+    jsmntok_t* tokens = NULL;
+    if (jsparse(js, len, &tokens) <= 0) {
+        arrfree(tokens);
+        file_unmap(&file);
+        return TX_PARSE_ERROR;
+    }
+
+    sprite_anim_db_free();
+
+    int clips_id = jsget_id(js, tokens, 0, "clips");
+    if (clips_id >= 0 && tokens[clips_id].type == JSMN_ARRAY) {
+        int clip_id = clips_id + 1;
+        for (int i = 0; i < tokens[clips_id].size && result == TX_SUCCESS; ++i) {
+            result = sprite_anim_load_clip(js, tokens, clip_id);
+            clip_id = jsskip(tokens, clip_id);
+        }
+    }
+
+    if (result != TX_SUCCESS) {
+        sprite_anim_db_free();
+    }
+
+    arrfree(tokens);
+    file_unmap(&file);
+
+    return result;
+}
+
+void sprite_anim_db_free(void)
+{
+    arrfree(clips);
+    arrfree(frames);
+}
+
+int32_t sprite_anim_clip_id(const char* name)
+{
+    const uint32_t hash = hash_string(name);
+    int32_t len = (int32_t)arrlen(clips);
+    for (int32_t i = 0; i < len; ++i) {
+        if (str_id_matches(clips[i].name, name, hash)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const struct sprite_anim_clip* sprite_anim_get_clips(int32_t* count)
+{
+    if (count) {
+        *count = (int32_t)arrlen(clips);
+    }
+    return clips;
+}
+
+const struct sprite_anim_frame* sprite_anim_get_frames(int32_t* count)
+{
+    if (count) {
+        *count = (int32_t)arrlen(frames);
+    }
+    return frames;
+}
+
+// Every loop mode is expressed through the clip's duration and last_step so advancing is the same
+// short arithmetic for every entity no matter which clip it plays:
+//  * looping clips wrap time by their duration, the step clamp only guards float rounding.
+//  * clips that play once never wrap (FLT_MAX duration) and clamp on their final frame. Their time
+//    is clamped to the clip too, a negative speed would otherwise wrap it to ~FLT_MAX.
+//  * ping pong clips were unrolled at load and loop.
+void sprite_anim_advance(SpriteAnimation* anims, int32_t count, float dt)
+{
+    const struct sprite_anim_clip* db = clips;
+    if (!db) {
+        return;
+    }
+
+    for (int32_t i = 0; i < count; ++i) {
+        const struct sprite_anim_clip* clip = &db[anims[i].clip];
+
+        float t = anims[i].time + dt * anims[i].speed;
+        if (clip->loop == SpriteAnimLoop_Once) {
+            t = fminf(fmaxf(t, 0.0f), clip->last_step / clip->fps);
+        } else {
+            t -= floorf(t / clip->duration) * clip->duration;
+        }
+        anims[i].time = t;
+
+        float step = fminf(fmaxf(t * clip->fps, 0.0f), clip->last_step);
+        anims[i].frame = (uint16_t)(clip->first_frame + (int32_t)step);
+    }
+}
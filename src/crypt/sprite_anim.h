@@ -0,0 +1,45 @@
+// sprite_anim.h - Sprite Animation Clips
+// clip definitions are loaded from json into one flat frame table shared by every animated sprite.
+// Entities only store a clip index and a playback time, the resolved frame is an index into the
+// frame table so the renderer never has to touch Sprite.sprite_id.
+
+#pragma once
+
+#include "str_id.h"
+#include "tx_types.h"
+
+typedef enum sprite_anim_loop {
+    SpriteAnimLoop_Loop = 0,
+    SpriteAnimLoop_Once,
+    SpriteAnimLoop_PingPong,
+} sprite_anim_loop;
+
+typedef struct SpriteAnimation {
+    uint16_t clip;
+    uint16_t frame; // index into the frame table, written by sprite_anim_advance
+    float time;  // seconds into the clip
+    float speed; // playback rate, negative plays backwards. 0 is replaced with 1 when set
+} SpriteAnimation;
+
+struct sprite_anim_frame {
+    uint16_t sprite_id;
+    uint8_t width;
+    uint8_t height;
+};
+
+struct sprite_anim_clip {
+    str_id name;
+    sprite_anim_loop loop;
+    float fps;
+    float duration;    // seconds until the timeline wraps, FLT_MAX for clips that play once
+    float last_step;   // timeline index of the final frame
+    int32_t first_frame;
+    int32_t frame_count; // length of the timeline, ping pong clips are stored unrolled
+};
+
+tx_result sprite_anim_db_load(const char* filename);
+void sprite_anim_db_free(void);
+int32_t sprite_anim_clip_id(const char* name);
+const struct sprite_anim_clip* sprite_anim_get_clips(int32_t* count);
+const struct sprite_anim_frame* sprite_anim_get_frames(int32_t* count);
+void sprite_anim_advance(SpriteAnimation* anims, int32_t count, float dt);
@@ -1,11 +1,20 @@
 #include "sprite_renderer.h"
+#include "assets.h"
+#include "debug_gui.h"
+#include "file_watch.h"
 #include "futils.h"
 #include "game_components.h"
+#include "hash.h"
+#include "jobs.h"
+#include "render_cmds.h"
+#include "scene.h"
+#include "shader_cache.h"
 #include "stb_ds.h"
-#include "stb_image.h"
 #include "string.h"
 #include "system_sdl2.h"
 #include <SDL2/SDL.h>
+#include <ccimgui.h>
+#include <float.h>
 
 // private system structs
 struct sprite {
@@ -14,6 +23,18 @@ struct sprite {
     vec2 origin;
     vec2 scale;
     vec4 color;
+    float page;
+};
+
+// Quantized alternative to struct sprite (SpriteInstanceFormat_Compact). Sprites are made of whole
+// 16x16 atlas tiles so the atlas rect and scale both come from the tile coordinates and size,
+// flipped axes are stored as negative sizes. Rows keep counting across atlas pages so the page
+// doesn't need its own attribute. Position stays full float for large levels.
+struct sprite_compact {
+    vec3 pos;
+    int8_t tile[4];    // atlas column, row across all pages, width, height (in tiles)
+    int16_t origin[2]; // normalized
+    uint8_t color[4];  // normalized
 };
 
 struct vertex {
@@ -26,18 +47,115 @@ struct vertex_color {
     vec4 col;
 };
 
-struct prim_line {
-    struct vertex_color v[2];
+// Lines and rects are both drawn as quads in a single indexed triangle stream. The quad index
+// pattern never changes so it lives in immutable index buffers instead of being pushed per rect.
+struct prim_quad {
+    struct vertex_color v[4];
+};
+
+// largest number of quads that can be addressed with 16-bit indices
+enum { K_PRIM_MAX_QUADS_U16 = 65536 / 4, K_PRIM_INITIAL_QUADS = 512 };
+
+// A run of entities from a single table that is gathered as one unit of work. Batches are recorded
+// in query order and each one writes to its own region of the sprite array starting at offset (a
+// prefix sum of the preceding batch counts) so the output doesn't depend on which thread ran it.
+struct gather_batch {
+    const Position* pos;
+    const Sprite* spr;
+    const SpriteColor* col;
+    const SpriteAnimation* anim;
+    bool spr_owned;
+    int32_t count;
+    int32_t offset;
+    int32_t written;
 };
 
-struct prim_rect {
-    struct vertex_color v[4];
+enum { K_GATHER_BATCH_SIZE = 2048 };
+
+struct render_stats {
+    int32_t sprites_drawn;
+    int32_t sprites_culled;
+    int32_t lines_drawn;
+    int32_t lines_culled;
+    int32_t rects_drawn;
+    int32_t rects_culled;
+    int32_t instance_bytes;
+    int32_t canvas_skips;
+    // sokol work, counted on the CPU side so it works with any backend
+    int32_t inst_upload_bytes;
+    int32_t prim_upload_bytes;
+    int32_t buffer_creates;
+    int32_t draw_calls;
+    int32_t pipeline_switches;
+    // milliseconds, upload is not included in submit
+    float gather_ms;
+    float upload_ms;
+    float submit_ms;
+};
+
+// rolling history of the stats that are plotted in the render stats panel
+struct render_stats_history {
+    int32_t t;
+    ecs_gauge_t gather_ms;
+    ecs_gauge_t upload_ms;
+    ecs_gauge_t submit_ms;
+    ecs_gauge_t upload_kb;
+    ecs_gauge_t draw_calls;
 };
 
 typedef struct uniform_block {
     mat4 view_proj;
 } uniform_block;
 
+// Everything the render thread needs to draw a frame. Once published the simulation side doesn't
+// touch a packet again until it comes back drawn, the instance and primitive arrays are handed over
+// by swapping pointers so nothing gets copied.
+struct frame_packet {
+    struct sprite* sprites;
+    struct sprite_compact* compact_sprites;
+    struct prim_quad* prims;
+    int32_t sprite_count;
+    int32_t prim_count;
+    // every camera draws the same instances and primitives
+    struct packet_view {
+        mat4 view_proj;
+        int32_t viewport[4];
+    } views[SPRITE_MAX_CAMERAS];
+    int32_t view_count;
+    sprite_present_mode present_mode;
+    // hash of everything that ends up in the canvas, 0 when unchanged canvases aren't skipped. The
+    // render thread folds in the resources the canvas pass binds.
+    uint32_t canvas_hash;
+    // everything needing the GL context that was recorded while the frame was built
+    struct render_cmd_list cmds[RenderCmdStage_Count];
+    // written by the render thread, read back when publish_frame_packet gets the packet returned
+    struct render_stats stats;
+    struct packet_shader_stats {
+        int32_t entries;
+        int32_t hits;
+        int32_t binary_loads;
+        int32_t misses;
+    } shader_stats;
+};
+
+enum { K_FRAME_PACKETS = 3, K_FRAME_PACKET_FRESH = 4 };
+
+// Triple buffer between publish_frame_packet on the main thread, which owns packets[write], and
+// the render thread, which owns packets[read]. The third packet is parked in `ready` and both sides
+// exchange theirs with it in a single atomic swap. K_FRAME_PACKET_FRESH marks a parked packet that
+// hasn't been acquired yet.
+// Packets carry render commands so none of them can be dropped, the semaphores only pace the two
+// sides: the render thread sleeps until a packet is published and publishing returns once the
+// render thread has taken it. Simulating frame N+1 overlaps with drawing frame N, never more.
+struct frame_mailbox {
+    struct frame_packet packets[K_FRAME_PACKETS];
+    int32_t write;
+    int32_t read;
+    SDL_atomic_t ready;
+    SDL_sem* published;
+    SDL_sem* acquired;
+};
+
 typedef struct renderer_resources {
     // sprite atlas
     sg_image atlas;
@@ -47,22 +165,20 @@ typedef struct renderer_resources {
     sg_buffer geom_ibuf;
     sg_buffer inst_vbuf;
 
-    // primitive line buffers
-    sg_buffer line_vbuf;
-
-    // primitive rect buffers
-    sg_buffer rect_vbuf;
-    sg_buffer rect_ibuf;
+    // primitive buffers, the 32-bit index buffer is only created if a frame needs it
+    sg_buffer prim_vbuf;
+    sg_buffer prim_ibuf16;
+    sg_buffer prim_ibuf32;
+    int32_t prim_ibuf32_quads;
 
     struct {
         sg_shader sprite_shader;
         sg_shader prim_shader;
         sg_pipeline pip;
         sg_bindings bindings;
-        sg_pipeline line_pip;
-        sg_bindings line_bindings;
-        sg_pipeline rect_pip;
-        sg_bindings rect_bindings;
+        sg_pipeline prim_pip16;
+        sg_pipeline prim_pip32;
+        sg_bindings prim_bindings;
         sg_pass pass;
         sg_pass_action pass_action;
         sg_image color_img;
@@ -77,21 +193,75 @@ typedef struct renderer_resources {
     } screen;
 } renderer_resources;
 
-typedef struct Renderer {
+// Everything the render thread owns. It's kept on the heap as the Renderer component can be moved
+// by flecs, and apart from the mailbox only the render thread touches it while it's running.
+struct render_device {
     SDL_Window* sdl_window;
+    SDL_GLContext gl;
+    SDL_Thread* thread;
     renderer_resources resources;
+    sprite_instance_format instance_format;
+    uint32_t canvas_width;
+    uint32_t canvas_height;
+    int32_t inst_vbuf_size;
+    int32_t prim_vbuf_size;
+    // hash of the packet the canvas image was last drawn from
+    uint32_t canvas_hash;
+    struct frame_mailbox frames;
+};
+
+typedef struct Renderer {
+    struct render_device* device;
     float pixels_per_meter;
     uint32_t canvas_width;
     uint32_t canvas_height;
+    sprite_instance_format instance_format;
     struct sprite* sprites;
-    struct prim_line* lines;
-    struct prim_rect* rects;
-    uint32_t* rect_indices;
+    struct sprite_compact* compact_sprites;
+    struct prim_quad* prims;
+    // atlas rect of every animation frame, 4 entries per frame indexed by sprite_flags
+    vec4* anim_rects;
+    // sprite table of the packed atlas, empty when the atlas was loaded from images
+    struct atlas_blob_sprite* atlas_sprites;
+    // where the atlas came from, kept around to reload it
+    const char* atlas_pages[SPRITE_MAX_ATLAS_PAGES];
+    int32_t atlas_page_count;
+    const char* atlas_blob_path;
+    // owns the bound atlas once streamed pages have been swapped in
+    asset_handle atlas_asset;
+    // pages still being streamed in, the bound atlas is replaced once they are ready
+    asset_handle atlas_pending;
+    // file watches of everything that can be reloaded while running
+    struct {
+        bool enabled;
+        int32_t sprite_shader[2];
+        int32_t prim_shader[2];
+        int32_t screen_shader[2];
+        int32_t atlas[SPRITE_MAX_ATLAS_PAGES];
+    } hot_reload;
     struct {
         float prim_layer;
     } prim_draw_state;
     ecs_query_t* q_sprites;
-    size_t prev_sprite_cap;
+    struct gather_batch* gather_batches;
+    bool parallel_gather;
+    bool validate_gather;
+    // sprite shader variant, untinted sprites skip the color mix
+    bool sprite_tint;
+    ecs_query_t* q_cameras;
+    // union of everything the cameras can see, anything outside of it is culled before it is
+    // appended to the frame's instance/primitive arrays.
+    struct view_rect view;
+    bool cull_enabled;
+    struct render_stats render_stats;
+    struct render_stats last_render_stats;
+    struct render_stats_history stats_history;
+    // sums of every finished frame, dumped by sprite_renderer_dump_stats
+    struct render_stats stats_total;
+    int32_t stats_frames;
+    struct packet_shader_stats last_shader_stats;
+    sprite_present_mode present_mode;
+    bool skip_unchanged_canvas;
 } Renderer;
 
 // private state
@@ -103,16 +273,35 @@ vec4 spr_calc_rect(uint32_t sprite_id, sprite_flags flip, uint16_t sw, uint16_t
 renderer_resources init_renderer_resources(
     SDL_Window* window,
     int initial_cap,
+    sprite_instance_format instance_format,
     uint32_t canvas_width,
-    uint32_t canvas_height);
+    uint32_t canvas_height,
+    const struct atlas_blob* atlas_blob);
+size_t sprite_instance_size(sprite_instance_format format);
 Renderer* try_get_r();
+void fill_quad_indices(void* indices, int32_t quad_count, bool wide);
+void calc_camera_view(
+    const Renderer* r, vec2 pos, float zoom, vec4 viewport_norm, CameraView* view);
+bool view_rect_overlaps(const struct view_rect* view, float x0, float y0, float x1, float y1);
+void renderer_watch_files(Renderer* r);
+void publish_frame_packet(Renderer* r);
+struct frame_packet* acquire_frame_packet(struct frame_mailbox* frames);
+int render_thread_main(void* data);
+bool try_replace_shader(sg_shader* shader, sg_shader new_shader, const char* name);
+
+float elapsed_ms(uint64_t start)
+{
+    uint64_t ticks = SDL_GetPerformanceCounter() - start;
+    return (float)((double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
 
 vec4 spr_calc_rect(uint32_t sprite_id, sprite_flags flip, uint16_t sw, uint16_t sh)
 {
     const int tc = 16;
     const float tcf = (float)tc;
 
-    uint32_t row = sprite_id / tc;
+    // the page is sampled from the texture array, the rect is within the page
+    uint32_t row = (sprite_id / tc) % tc;
     uint32_t col = sprite_id % tc;
 
     const float flip_offsets[3] = {0.0f, 1.0f, 1.0f};
@@ -130,91 +319,69 @@ vec4 spr_calc_rect(uint32_t sprite_id, sprite_flags flip, uint16_t sw, uint16_t
     return (vec4){(col + fx) / tcf, (row + fy) / tcf, fw / tc, fh / tc};
 }
 
-renderer_resources init_renderer_resources(
-    SDL_Window* window,
-    int initial_cap,
-    uint32_t canvas_width,
-    uint32_t canvas_height)
+size_t sprite_instance_size(sprite_instance_format format)
 {
-    renderer_resources resources;
-    memset(&resources, 0, sizeof(renderer_resources));
+    switch (format) {
+    case SpriteInstanceFormat_Compact:
+        return sizeof(struct sprite_compact);
+    default:
+        return sizeof(struct sprite);
+    }
+}
 
-    // Configure render target render
-    int iw, ih, ichan;
-    stbi_uc* pixels = stbi_load("assets/atlas.png", &iw, &ih, &ichan, 4);
-    TX_ASSERT(pixels);
+struct sprite_compact pack_sprite_compact(
+    vec3 pos,
+    uint32_t sprite_id,
+    sprite_flags flip,
+    uint16_t sw,
+    uint16_t sh,
+    vec2 origin,
+    vec4 color)
+{
+    const int tc = 16;
 
-    resources.atlas = sg_make_image(&(sg_image_desc){
-        .width = iw,
-        .height = ih,
-        .pixel_format = SG_PIXELFORMAT_RGBA8,
-        .min_filter = SG_FILTER_NEAREST,
-        .mag_filter = SG_FILTER_NEAREST,
-        .content.subimage[0][0] =
+    int32_t w = (flip & SpriteFlags_FlipX) ? -(int32_t)sw : (int32_t)sw;
+    int32_t h = (flip & SpriteFlags_FlipY) ? -(int32_t)sh : (int32_t)sh;
+
+    return (struct sprite_compact){
+        .pos = pos,
+        .tile = {(int8_t)(sprite_id % tc), (int8_t)(sprite_id / tc), (int8_t)w, (int8_t)h},
+        .origin =
             {
-                .ptr = pixels,
-                .size = iw * ih * ichan,
+                (int16_t)(clampf(origin.x, -1.0f, 1.0f) * INT16_MAX),
+                (int16_t)(clampf(origin.y, -1.0f, 1.0f) * INT16_MAX),
+            },
+        .color =
+            {
+                (uint8_t)(clampf(color.x, 0.0f, 1.0f) * UINT8_MAX + 0.5f),
+                (uint8_t)(clampf(color.y, 0.0f, 1.0f) * UINT8_MAX + 0.5f),
+                (uint8_t)(clampf(color.z, 0.0f, 1.0f) * UINT8_MAX + 0.5f),
+                (uint8_t)(clampf(color.w, 0.0f, 1.0f) * UINT8_MAX + 0.5f),
             },
-    });
-
-    stbi_image_free(pixels);
-
-    const float k_size = 1.0f;
-    struct vertex quad_verts[] = {
-        {.pos = {.x = 0, .y = 0}, .uv = {.x = 0.0f, .y = 0.0f}},
-        {.pos = {.x = k_size, .y = 0}, .uv = {.x = 1.0f, .y = 0.0f}},
-        {.pos = {.x = k_size, .y = k_size}, .uv = {.x = 1.0f, .y = 1.0f}},
-        {.pos = {.x = 0, .y = k_size}, .uv = {.x = 0.0f, .y = 1.0f}},
     };
+}
 
-    const uint16_t quad_indices[] = {0, 2, 3, 0, 1, 2};
-
-    resources.geom_vbuf = sg_make_buffer(&(sg_buffer_desc){
-        .content = quad_verts,
-        .size = sizeof(quad_verts),
-    });
-
-    resources.geom_ibuf = sg_make_buffer(&(sg_buffer_desc){
-        .type = SG_BUFFERTYPE_INDEXBUFFER,
-        .content = quad_indices,
-        .size = sizeof(quad_indices),
-    });
-
-    resources.inst_vbuf = sg_make_buffer(&(sg_buffer_desc){
-        .usage = SG_USAGE_STREAM,
-        .size = sizeof(struct sprite) * initial_cap,
-    });
-
-    resources.line_vbuf = sg_make_buffer(&(sg_buffer_desc){
-        .usage = SG_USAGE_STREAM,
-        .size = sizeof(struct prim_line) * 256,
-    });
-
-    resources.rect_vbuf = sg_make_buffer(&(sg_buffer_desc){
-        .usage = SG_USAGE_STREAM,
-        .size = sizeof(struct prim_rect) * 256,
-    });
-
-    resources.rect_ibuf = sg_make_buffer(&(sg_buffer_desc){
-        .type = SG_BUFFERTYPE_INDEXBUFFER,
-        .usage = SG_USAGE_STREAM,
-        .size = sizeof(uint32_t) * 256 * 6,
-    });
-
-    // load sprite shader
-    {
-        char* vs_buffer;
-        char* fs_buffer;
-        size_t vs_len, fs_len;
-
-        enum tx_result vs_result =
-            read_file_to_buffer("assets/shaders/sprite.vert", &vs_buffer, &vs_len);
-        enum tx_result fs_result =
-            read_file_to_buffer("assets/shaders/sprite.frag", &fs_buffer, &fs_len);
+bool shader_is_valid(sg_shader shader)
+{
+    return shader.id != SG_INVALID_ID && sg_query_shader_state(shader) == SG_RESOURCESTATE_VALID;
+}
 
-        TX_ASSERT(vs_result == TX_SUCCESS && fs_result == TX_SUCCESS);
+const char* sprite_vs_filename(sprite_instance_format instance_format)
+{
+    return (instance_format == SpriteInstanceFormat_Compact) ? "assets/shaders/sprite_compact.vert"
+                                                             : "assets/shaders/sprite.vert";
+}
 
-        resources.canvas.sprite_shader = sg_make_shader(&(sg_shader_desc){
+sg_shader make_sprite_shader(sprite_instance_format instance_format, bool tint)
+{
+    const char* defines[] = {"SPRITE_TINT"};
+
+    return shader_cache_load(
+        sprite_vs_filename(instance_format),
+        "assets/shaders/sprite.frag",
+        defines,
+        (tint) ? 1 : 0,
+        (sg_shader_desc){
             .vs.uniform_blocks[0] =
                 {
                     .size = sizeof(uniform_block),
@@ -223,29 +390,18 @@ renderer_resources init_renderer_resources(
                             [0] = {.name = "view_proj", .type = SG_UNIFORMTYPE_MAT4},
                         },
                 },
-            .fs.images[0] = {.name = "atlas", .type = SG_IMAGETYPE_2D},
-            .vs.source = vs_buffer,
-            .fs.source = fs_buffer,
+            .fs.images[0] = {.name = "atlas", .type = SG_IMAGETYPE_ARRAY},
         });
+}
 
-        free(vs_buffer);
-        free(fs_buffer);
-    }
-
-    // load primitive shader
-    {
-        char* vs_buffer;
-        char* fs_buffer;
-        size_t vs_len, fs_len;
-
-        enum tx_result vs_result =
-            read_file_to_buffer("assets/shaders/primitive.vert", &vs_buffer, &vs_len);
-        enum tx_result fs_result =
-            read_file_to_buffer("assets/shaders/primitive.frag", &fs_buffer, &fs_len);
-
-        TX_ASSERT(vs_result == TX_SUCCESS && fs_result == TX_SUCCESS);
-
-        resources.canvas.prim_shader = sg_make_shader(&(sg_shader_desc){
+sg_shader make_prim_shader()
+{
+    return shader_cache_load(
+        "assets/shaders/primitive.vert",
+        "assets/shaders/primitive.frag",
+        NULL,
+        0,
+        (sg_shader_desc){
             .vs.uniform_blocks[0] =
                 {
                     .size = sizeof(uniform_block),
@@ -254,93 +410,110 @@ renderer_resources init_renderer_resources(
                             [0] = {.name = "view_proj", .type = SG_UNIFORMTYPE_MAT4},
                         },
                 },
-            .vs.source = vs_buffer,
-            .fs.source = fs_buffer,
         });
+}
 
-        free(vs_buffer);
-        free(fs_buffer);
-    }
-
-    sg_image_desc image_desc = (sg_image_desc){
-        .render_target = true,
-        .width = canvas_width,
-        .height = canvas_height,
-        .min_filter = SG_FILTER_NEAREST,
-        .mag_filter = SG_FILTER_NEAREST,
-        .pixel_format = SG_PIXELFORMAT_RGBA8,
-    };
-
-    resources.canvas.color_img = sg_make_image(&image_desc);
-    image_desc.pixel_format = SG_PIXELFORMAT_DEPTH;
-    resources.canvas.depth_img = sg_make_image(&image_desc);
-
-    resources.canvas.pass = sg_make_pass(&(sg_pass_desc){
-        .color_attachments[0].image = resources.canvas.color_img,
-        .depth_stencil_attachment.image = resources.canvas.depth_img,
-    });
+sg_shader make_screen_shader()
+{
+    return shader_cache_load(
+        "assets/shaders/fullscreen_quad.vert",
+        "assets/shaders/fullscreen_quad.frag",
+        NULL,
+        0,
+        (sg_shader_desc){
+            .fs.images[0] = {.name = "screen_texture", .type = SG_IMAGETYPE_2D},
+        });
+}
 
-    // default render states are fine for triangle
-    resources.canvas.pip = sg_make_pipeline(&(sg_pipeline_desc){
-        .shader = resources.canvas.sprite_shader,
-        .index_type = SG_INDEXTYPE_UINT16,
-        .layout =
+sg_pipeline make_sprite_pipeline(sg_shader shader, sprite_instance_format instance_format)
+{
+    // both instance formats share the per vertex quad in buffer 0
+    sg_layout_desc sprite_layout = (sg_layout_desc){
+        .buffers =
             {
-                .buffers =
+                [0] = {.stride = sizeof(struct vertex)},
+                [1] =
                     {
-                        [0] = {.stride = sizeof(struct vertex)},
-                        [1] =
-                            {
-                                .stride = sizeof(struct sprite),
-                                .step_func = SG_VERTEXSTEP_PER_INSTANCE,
-                            },
+                        .stride = (int)sprite_instance_size(instance_format),
+                        .step_func = SG_VERTEXSTEP_PER_INSTANCE,
                     },
-                .attrs =
+            },
+        .attrs =
+            {
+                [0] =
                     {
-                        [0] =
-                            {
-                                .format = SG_VERTEXFORMAT_FLOAT2,
-                                .offset = 0,
-                                .buffer_index = 0,
-                            },
-                        [1] =
-                            {
-                                .format = SG_VERTEXFORMAT_FLOAT2,
-                                .offset = 8,
-                                .buffer_index = 0,
-                            },
-                        [2] =
-                            {
-                                .format = SG_VERTEXFORMAT_FLOAT3,
-                                .offset = 0,
-                                .buffer_index = 1,
-                            },
-                        [3] =
-                            {
-                                .format = SG_VERTEXFORMAT_FLOAT4,
-                                .offset = 12,
-                                .buffer_index = 1,
-                            },
-                        [4] =
-                            {
-                                .format = SG_VERTEXFORMAT_FLOAT2,
-                                .offset = 28,
-                                .buffer_index = 1,
-                            },
-                        [5] =
-                            {
-                                .format = SG_VERTEXFORMAT_FLOAT2,
-                                .offset = 36,
-                                .buffer_index = 1,
-                            },
-                        [6] =
-                            {
-                                .format = SG_VERTEXFORMAT_FLOAT4,
-                                .offset = 44,
-                                .buffer_index = 1,
-                            },
+                        .format = SG_VERTEXFORMAT_FLOAT2,
+                        .offset = 0,
+                        .buffer_index = 0,
+                    },
+                [1] =
+                    {
+                        .format = SG_VERTEXFORMAT_FLOAT2,
+                        .offset = 8,
+                        .buffer_index = 0,
                     },
             },
+    };
+
+    if (instance_format == SpriteInstanceFormat_Compact) {
+        sprite_layout.attrs[2] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_FLOAT3,
+            .offset = offsetof(struct sprite_compact, pos),
+            .buffer_index = 1,
+        };
+        sprite_layout.attrs[3] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_BYTE4,
+            .offset = offsetof(struct sprite_compact, tile),
+            .buffer_index = 1,
+        };
+        sprite_layout.attrs[4] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_SHORT2N,
+            .offset = offsetof(struct sprite_compact, origin),
+            .buffer_index = 1,
+        };
+        sprite_layout.attrs[5] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_UBYTE4N,
+            .offset = offsetof(struct sprite_compact, color),
+            .buffer_index = 1,
+        };
+    } else {
+        sprite_layout.attrs[2] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_FLOAT3,
+            .offset = 0,
+            .buffer_index = 1,
+        };
+        sprite_layout.attrs[3] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_FLOAT4,
+            .offset = 12,
+            .buffer_index = 1,
+        };
+        sprite_layout.attrs[4] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_FLOAT2,
+            .offset = 28,
+            .buffer_index = 1,
+        };
+        sprite_layout.attrs[5] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_FLOAT2,
+            .offset = 36,
+            .buffer_index = 1,
+        };
+        sprite_layout.attrs[6] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_FLOAT4,
+            .offset = 44,
+            .buffer_index = 1,
+        };
+        sprite_layout.attrs[7] = (sg_vertex_attr_desc){
+            .format = SG_VERTEXFORMAT_FLOAT,
+            .offset = 60,
+            .buffer_index = 1,
+        };
+    }
+
+    // default render states are fine for triangle
+    return sg_make_pipeline(&(sg_pipeline_desc){
+        .shader = shader,
+        .index_type = SG_INDEXTYPE_UINT16,
+        .layout = sprite_layout,
         .depth_stencil =
             {
                 .depth_compare_func = SG_COMPAREFUNC_LESS_EQUAL,
@@ -358,20 +531,13 @@ renderer_resources init_renderer_resources(
             },
         .rasterizer.cull_mode = SG_CULLMODE_BACK,
     });
+}
 
-    resources.canvas.bindings = (sg_bindings){
-        .vertex_buffers =
-            {
-                [0] = resources.geom_vbuf,
-                [1] = resources.inst_vbuf,
-            },
-        .index_buffer = resources.geom_ibuf,
-        .fs_images[0] = resources.atlas,
-    };
-
+void make_prim_pipelines(sg_shader shader, sg_pipeline* pip16, sg_pipeline* pip32)
+{
     // primitive pipelines share many similarities so create a base structure here
     sg_pipeline_desc base_prim_pip = (sg_pipeline_desc){
-        .shader = resources.canvas.prim_shader,
+        .shader = shader,
         .layout =
             {
                 .buffers[0] = {.stride = sizeof(struct vertex_color)},
@@ -405,58 +571,29 @@ renderer_resources init_renderer_resources(
                 .src_factor_alpha = SG_BLENDFACTOR_ONE,
                 .dst_factor_alpha = SG_BLENDFACTOR_ZERO,
             },
-        .rasterizer.cull_mode = SG_CULLMODE_BACK,
-    };
-
-    // Setup primtive line drawing pipeline and bindings
-    sg_pipeline_desc prim_line_pip = base_prim_pip;
-    prim_line_pip.primitive_type = SG_PRIMITIVETYPE_LINES;
-    prim_line_pip.index_type = SG_INDEXTYPE_NONE;
-
-    resources.canvas.line_pip = sg_make_pipeline(&prim_line_pip);
-    resources.canvas.line_bindings = (sg_bindings){
-        .vertex_buffers[0] = resources.line_vbuf,
-    };
-
-    // Setup primitive rect drawing pipeline and bindings
-    sg_pipeline_desc prim_rect_pip = base_prim_pip;
-    prim_rect_pip.primitive_type = SG_PRIMITIVETYPE_TRIANGLES;
-    prim_rect_pip.index_type = SG_INDEXTYPE_UINT32;
-
-    resources.canvas.rect_pip = sg_make_pipeline(&prim_rect_pip);
-    resources.canvas.rect_bindings = (sg_bindings){
-        .vertex_buffers[0] = resources.rect_vbuf,
-        .index_buffer = resources.rect_ibuf,
+        .rasterizer.cull_mode = SG_CULLMODE_NONE,
     };
 
-    // Configure screen full-screen quad render
-    {
-        char* vs_buffer;
-        char* fs_buffer;
-        size_t vs_len, fs_len;
-
-        enum tx_result vs_result =
-            read_file_to_buffer("assets/shaders/fullscreen_quad.vert", &vs_buffer, &vs_len);
-        enum tx_result fs_result =
-            read_file_to_buffer("assets/shaders/fullscreen_quad.frag", &fs_buffer, &fs_len);
-
-        TX_ASSERT(vs_result == TX_SUCCESS && fs_result == TX_SUCCESS);
+    // Lines and rects share one triangle pipeline, the index width is baked into the pipeline so
+    // there is one for each.
+    base_prim_pip.primitive_type = SG_PRIMITIVETYPE_TRIANGLES;
 
-        resources.screen.shader = sg_make_shader(&(sg_shader_desc){
-            .fs.images[0] = {.name = "screen_texture", .type = SG_IMAGETYPE_2D},
-            .vs.source = vs_buffer,
-            .fs.source = fs_buffer,
-        });
+    sg_pipeline_desc prim_pip16 = base_prim_pip;
+    prim_pip16.index_type = SG_INDEXTYPE_UINT16;
+    *pip16 = sg_make_pipeline(&prim_pip16);
 
-        free(vs_buffer);
-        free(fs_buffer);
-    }
+    sg_pipeline_desc prim_pip32 = base_prim_pip;
+    prim_pip32.index_type = SG_INDEXTYPE_UINT32;
+    *pip32 = sg_make_pipeline(&prim_pip32);
+}
 
+sg_pipeline make_screen_pipeline(sg_shader shader)
+{
     // Our fullscreen quad shader doesn't require any attributes but sokol has no mechanism for
     // for binding empty attribute arrays so define a per-instance float so *something* goes across
     // and sokol is happy.
-    resources.screen.pip = sg_make_pipeline(&(sg_pipeline_desc){
-        .shader = resources.screen.shader,
+    return sg_make_pipeline(&(sg_pipeline_desc){
+        .shader = shader,
         .layout =
             {
                 .buffers[0] =
@@ -469,68 +606,303 @@ renderer_resources init_renderer_resources(
                     },
             },
     });
-
-    static const float data = 0.0f;
-    resources.screen.bindings = (sg_bindings){
-        .vertex_buffers[0] = sg_make_buffer(&(sg_buffer_desc){
-            .usage = SG_USAGE_IMMUTABLE,
-            .size = sizeof(float),
-            .content = &data,
-        }),
-        .fs_images[0] = resources.canvas.color_img,
-    };
-
-    resources.screen.pass_action = (sg_pass_action){
-        .colors[0] = {.action = SG_ACTION_CLEAR, .val = {0.0f, 0.0f, 0.0f}},
-    };
-
-    return resources;
 }
 
-Renderer* try_get_r()
+sg_image make_atlas_blob_image(const struct atlas_blob* atlas_blob)
 {
-    if (!q_renderer) {
-        return NULL;
-    }
-
-    ecs_iter_t it = ecs_query_iter(q_renderer);
-    if (ecs_query_next(&it)) {
-        return ecs_term(&it, Renderer, 1);
-    }
-
-    return NULL;
+    const struct atlas_blob_header* header = &atlas_blob->header;
+
+    // the blob is already in texture array layout
+    return sg_make_image(&(sg_image_desc){
+        .type = SG_IMAGETYPE_ARRAY,
+        .width = header->page_width,
+        .height = header->page_height,
+        .layers = header->page_count,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .content.subimage[0][0] =
+            {
+                .ptr = atlas_blob->pixels,
+                .size = (int)header->pixels_size,
+            },
+    });
 }
 
-void draw_line_col2(vec2 from, vec2 to, vec4 col0, vec4 col1)
+renderer_resources init_renderer_resources(
+    SDL_Window* window,
+    int initial_cap,
+    sprite_instance_format instance_format,
+    uint32_t canvas_width,
+    uint32_t canvas_height,
+    const struct atlas_blob* atlas_blob)
 {
-    Renderer* r = try_get_r();
+    renderer_resources resources;
+    memset(&resources, 0, sizeof(renderer_resources));
 
-    if (!r) {
-        return;
+    // Load every atlas page into one texture array so sprites from any page are drawn by the same
+    // pipeline and bindings
+    if (atlas_blob) {
+        // sprite ids and the compact shader assume 16x16 tile pages
+        TX_ASSERT(
+            atlas_blob->header.page_tiles == 16 &&
+            atlas_blob->header.page_count <= SPRITE_MAX_ATLAS_PAGES);
+
+        resources.atlas = make_atlas_blob_image(atlas_blob);
+    } else {
+        // atlas pages are streamed in by the asset loader, sprites draw with a blank page until
+        // the renderer swaps the real atlas in
+        const uint8_t blank[4] = {0, 0, 0, 0};
+        resources.atlas = sg_make_image(&(sg_image_desc){
+            .type = SG_IMAGETYPE_ARRAY,
+            .width = 1,
+            .height = 1,
+            .layers = 1,
+            .pixel_format = SG_PIXELFORMAT_RGBA8,
+            .min_filter = SG_FILTER_NEAREST,
+            .mag_filter = SG_FILTER_NEAREST,
+            .content.subimage[0][0] =
+                {
+                    .ptr = blank,
+                    .size = sizeof(blank),
+                },
+        });
     }
 
-    float layer = -r->prim_draw_state.prim_layer;
-    struct prim_line line = {
-        .v[0] = {.pos = (vec3){.x = from.x, .y = from.y, .z = layer}, .col = col0},
-        .v[1] = {.pos = (vec3){.x = to.x, .y = to.y, .z = layer}, .col = col1},
+    const float k_size = 1.0f;
+    struct vertex quad_verts[] = {
+        {.pos = {.x = 0, .y = 0}, .uv = {.x = 0.0f, .y = 0.0f}},
+        {.pos = {.x = k_size, .y = 0}, .uv = {.x = 1.0f, .y = 0.0f}},
+        {.pos = {.x = k_size, .y = k_size}, .uv = {.x = 1.0f, .y = 1.0f}},
+        {.pos = {.x = 0, .y = k_size}, .uv = {.x = 0.0f, .y = 1.0f}},
     };
 
-    size_t prev_cap = arrcap(r->lines);
-
-    arrput(r->lines, line);
+    const uint16_t quad_indices[] = {0, 2, 3, 0, 1, 2};
 
-    size_t cap = arrcap(r->lines);
-    if (cap > prev_cap) {
-        sg_destroy_buffer(r->resources.line_vbuf);
-        r->resources.line_vbuf = sg_make_buffer(&(sg_buffer_desc){
-            .usage = SG_USAGE_STREAM,
-            .size = (int)(sizeof(struct prim_line) * cap),
-        });
-        r->resources.canvas.line_bindings.vertex_buffers[0] = r->resources.line_vbuf;
-    }
-}
+    resources.geom_vbuf = sg_make_buffer(&(sg_buffer_desc){
+        .content = quad_verts,
+        .size = sizeof(quad_verts),
+    });
 
-void draw_line_col(vec2 from, vec2 to, vec4 col)
+    resources.geom_ibuf = sg_make_buffer(&(sg_buffer_desc){
+        .type = SG_BUFFERTYPE_INDEXBUFFER,
+        .content = quad_indices,
+        .size = sizeof(quad_indices),
+    });
+
+    resources.inst_vbuf = sg_make_buffer(&(sg_buffer_desc){
+        .usage = SG_USAGE_STREAM,
+        .size = (int)(sprite_instance_size(instance_format) * initial_cap),
+    });
+
+    resources.prim_vbuf = sg_make_buffer(&(sg_buffer_desc){
+        .usage = SG_USAGE_STREAM,
+        .size = sizeof(struct prim_quad) * K_PRIM_INITIAL_QUADS,
+    });
+
+    {
+        uint16_t* prim_indices = (uint16_t*)malloc(sizeof(uint16_t) * 6 * K_PRIM_MAX_QUADS_U16);
+        fill_quad_indices(prim_indices, K_PRIM_MAX_QUADS_U16, false);
+
+        resources.prim_ibuf16 = sg_make_buffer(&(sg_buffer_desc){
+            .type = SG_BUFFERTYPE_INDEXBUFFER,
+            .usage = SG_USAGE_IMMUTABLE,
+            .content = prim_indices,
+            .size = sizeof(uint16_t) * 6 * K_PRIM_MAX_QUADS_U16,
+        });
+
+        free(prim_indices);
+    }
+
+    resources.canvas.sprite_shader = make_sprite_shader(instance_format, true);
+    resources.canvas.prim_shader = make_prim_shader();
+    TX_ASSERT(
+        shader_is_valid(resources.canvas.sprite_shader) &&
+        shader_is_valid(resources.canvas.prim_shader));
+
+    sg_image_desc image_desc = (sg_image_desc){
+        .render_target = true,
+        .width = canvas_width,
+        .height = canvas_height,
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+    };
+
+    resources.canvas.color_img = sg_make_image(&image_desc);
+    image_desc.pixel_format = SG_PIXELFORMAT_DEPTH;
+    resources.canvas.depth_img = sg_make_image(&image_desc);
+
+    resources.canvas.pass = sg_make_pass(&(sg_pass_desc){
+        .color_attachments[0].image = resources.canvas.color_img,
+        .depth_stencil_attachment.image = resources.canvas.depth_img,
+    });
+
+    resources.canvas.pip = make_sprite_pipeline(resources.canvas.sprite_shader, instance_format);
+
+    resources.canvas.bindings = (sg_bindings){
+        .vertex_buffers =
+            {
+                [0] = resources.geom_vbuf,
+                [1] = resources.inst_vbuf,
+            },
+        .index_buffer = resources.geom_ibuf,
+        .fs_images[0] = resources.atlas,
+    };
+
+    make_prim_pipelines(
+        resources.canvas.prim_shader, &resources.canvas.prim_pip16, &resources.canvas.prim_pip32);
+
+    resources.canvas.prim_bindings = (sg_bindings){
+        .vertex_buffers[0] = resources.prim_vbuf,
+        .index_buffer = resources.prim_ibuf16,
+    };
+
+    // Configure screen full-screen quad render
+    resources.screen.shader = make_screen_shader();
+    TX_ASSERT(shader_is_valid(resources.screen.shader));
+    resources.screen.pip = make_screen_pipeline(resources.screen.shader);
+
+    static const float data = 0.0f;
+    resources.screen.bindings = (sg_bindings){
+        .vertex_buffers[0] = sg_make_buffer(&(sg_buffer_desc){
+            .usage = SG_USAGE_IMMUTABLE,
+            .size = sizeof(float),
+            .content = &data,
+        }),
+        .fs_images[0] = resources.canvas.color_img,
+    };
+
+    resources.screen.pass_action = (sg_pass_action){
+        .colors[0] = {.action = SG_ACTION_CLEAR, .val = {0.0f, 0.0f, 0.0f}},
+    };
+
+    return resources;
+}
+
+// Writes the two triangle (0, 2, 3), (0, 1, 2) pattern for quad_count consecutive quads
+void fill_quad_indices(void* indices, int32_t quad_count, bool wide)
+{
+    const static uint32_t index_offsets[6] = {0, 2, 3, 0, 1, 2};
+
+    for (int32_t q = 0; q < quad_count; ++q) {
+        uint32_t base_idx = (uint32_t)q * 4;
+        for (int32_t i = 0; i < 6; ++i) {
+            if (wide) {
+                ((uint32_t*)indices)[q * 6 + i] = base_idx + index_offsets[i];
+            } else {
+                ((uint16_t*)indices)[q * 6 + i] = (uint16_t)(base_idx + index_offsets[i]);
+            }
+        }
+    }
+}
+
+void push_prim_quad(Renderer* r, const struct prim_quad* quad)
+{
+    arrput(r->prims, *quad);
+}
+
+// The canvas pixel size of a normalized viewport, a zero sized viewport covers the whole canvas.
+void calc_camera_viewport(const Renderer* r, vec4 viewport_norm, int32_t viewport[4])
+{
+    if (viewport_norm.z <= 0.0f || viewport_norm.w <= 0.0f) {
+        viewport_norm = (vec4){0.0f, 0.0f, 1.0f, 1.0f};
+    }
+
+    viewport[0] = (int32_t)(viewport_norm.x * r->canvas_width);
+    viewport[1] = (int32_t)(viewport_norm.y * r->canvas_height);
+    viewport[2] = (int32_t)(viewport_norm.z * r->canvas_width);
+    viewport[3] = (int32_t)(viewport_norm.w * r->canvas_height);
+}
+
+void calc_camera_view(
+    const Renderer* r, vec2 pos, float zoom, vec4 viewport_norm, CameraView* view)
+{
+    calc_camera_viewport(r, viewport_norm, view->viewport);
+
+    const float view_half_width = (view->viewport[2] / r->pixels_per_meter) * zoom / 2;
+    const float view_half_height = (view->viewport[3] / r->pixels_per_meter) * zoom / 2;
+
+    mat4 look = mat4_look_at((vec3){pos.x, pos.y, 0}, (vec3){pos.x, pos.y, -1.0f}, (vec3){0, 1, 0});
+    mat4 projection = mat4_ortho(
+        -view_half_width, view_half_width, view_half_height, -view_half_height, 0.0f, 1000.0f);
+
+    view->view_proj = mat4_mul(projection, look);
+    view->visible = (struct view_rect){
+        .left = pos.x - view_half_width,
+        .right = pos.x + view_half_width,
+        .top = pos.y - view_half_height,
+        .bottom = pos.y + view_half_height,
+    };
+    view->pos = pos;
+    view->zoom = zoom;
+    view->viewport_norm = viewport_norm;
+}
+
+// Test an axis aligned box against the view, the corners can be given in any order.
+bool view_rect_overlaps(const struct view_rect* view, float x0, float y0, float x1, float y1)
+{
+    float min_x = (x0 < x1) ? x0 : x1;
+    float max_x = (x0 < x1) ? x1 : x0;
+    float min_y = (y0 < y1) ? y0 : y1;
+    float max_y = (y0 < y1) ? y1 : y0;
+
+    return min_x <= view->right && max_x >= view->left && min_y <= view->bottom
+           && max_y >= view->top;
+}
+
+Renderer* try_get_r()
+{
+    if (!q_renderer) {
+        return NULL;
+    }
+
+    ecs_iter_t it = ecs_query_iter(q_renderer);
+    if (ecs_query_next(&it)) {
+        return ecs_term(&it, Renderer, 1);
+    }
+
+    return NULL;
+}
+
+void draw_line_col2(vec2 from, vec2 to, vec4 col0, vec4 col1)
+{
+    Renderer* r = try_get_r();
+
+    if (!r) {
+        return;
+    }
+
+    if (r->cull_enabled && !view_rect_overlaps(&r->view, from.x, from.y, to.x, to.y)) {
+        r->render_stats.lines_culled++;
+        return;
+    }
+    r->render_stats.lines_drawn++;
+
+    // expand the line into a quad one canvas pixel wide
+    vec2 dir = vec2_sub(to, from);
+    float len = sqrtf(dir.x * dir.x + dir.y * dir.y);
+    if (len > 0.0f) {
+        dir = vec2_scale(dir, 1.0f / len);
+    } else {
+        dir = (vec2){.x = 1.0f, .y = 0.0f};
+    }
+
+    float half_width = 0.5f / r->pixels_per_meter;
+    vec2 n = (vec2){.x = -dir.y * half_width, .y = dir.x * half_width};
+
+    float layer = -r->prim_draw_state.prim_layer;
+    struct prim_quad quad = {
+        .v[0] = {.pos = (vec3){.x = from.x + n.x, .y = from.y + n.y, .z = layer}, .col = col0},
+        .v[1] = {.pos = (vec3){.x = to.x + n.x, .y = to.y + n.y, .z = layer}, .col = col1},
+        .v[2] = {.pos = (vec3){.x = to.x - n.x, .y = to.y - n.y, .z = layer}, .col = col1},
+        .v[3] = {.pos = (vec3){.x = from.x - n.x, .y = from.y - n.y, .z = layer}, .col = col0},
+    };
+
+    push_prim_quad(r, &quad);
+}
+
+void draw_line_col(vec2 from, vec2 to, vec4 col)
 {
     draw_line_col2(from, to, col, col);
 }
@@ -562,42 +934,21 @@ void draw_rect_col4(vec2 p0, vec2 p1, vec4 cols[4])
         return;
     }
 
-    const static uint32_t index_offsets[6] = {0, 2, 3, 0, 1, 2};
+    if (r->cull_enabled && !view_rect_overlaps(&r->view, p0.x, p0.y, p1.x, p1.y)) {
+        r->render_stats.rects_culled++;
+        return;
+    }
+    r->render_stats.rects_drawn++;
 
     float layer = -r->prim_draw_state.prim_layer;
-    struct prim_rect rect = {
+    struct prim_quad quad = {
         .v[0] = {.pos = (vec3){.x = p0.x, .y = p0.y, .z = layer}, .col = cols[0]},
         .v[1] = {.pos = (vec3){.x = p1.x, .y = p0.y, .z = layer}, .col = cols[1]},
         .v[2] = {.pos = (vec3){.x = p1.x, .y = p1.y, .z = layer}, .col = cols[2]},
         .v[3] = {.pos = (vec3){.x = p0.x, .y = p1.y, .z = layer}, .col = cols[3]},
     };
 
-    size_t prev_cap = arrcap(r->rects);
-
-    uint32_t base_idx = (uint32_t)(arrlen(r->rect_indices) / 6) * 4;
-
-    arrput(r->rects, rect);
-    for (int32_t i = 0; i < 6; ++i) {
-        arrput(r->rect_indices, base_idx + index_offsets[i]);
-    }
-
-    size_t cap = arrcap(r->rects);
-    if (cap > prev_cap) {
-        sg_destroy_buffer(r->resources.rect_vbuf);
-        sg_destroy_buffer(r->resources.rect_ibuf);
-
-        r->resources.rect_vbuf = sg_make_buffer(&(sg_buffer_desc){
-            .usage = SG_USAGE_STREAM,
-            .size = (int)(sizeof(struct prim_rect) * cap),
-        });
-        r->resources.rect_ibuf = sg_make_buffer(&(sg_buffer_desc){
-            .usage = SG_USAGE_STREAM,
-            .size = (int)(sizeof(uint32_t) * 6 * cap),
-        });
-
-        r->resources.canvas.rect_bindings.vertex_buffers[0] = r->resources.rect_vbuf;
-        r->resources.canvas.rect_bindings.index_buffer = r->resources.rect_ibuf;
-    }
+    push_prim_quad(r, &quad);
 }
 
 void draw_rect_col(vec2 p0, vec2 p1, vec4 col)
@@ -649,23 +1000,11 @@ void draw_reset_prim_layer()
     draw_set_prim_layer(0.0f);
 }
 
-int compare_sprite_layers(ecs_entity_t e1, const Sprite* s1, ecs_entity_t e2, const Sprite* s2)
-{
-    if (s1->layer == s2->layer) {
-        return 0;
-    } else if (s1->layer < s2->layer) {
-        return -1;
-    } else {
-        return 1;
-    }
-}
-
 void AttachRenderer(ecs_iter_t* it)
 {
     ecs_world_t* world = it->world;
     SpriteRenderConfig* config = ecs_term(it, SpriteRenderConfig, 1);
     ecs_entity_t ecs_typeid(Renderer) = ecs_term_id(it, 2);
-    ecs_id_t ecs_id(Sprite) = ecs_term_id(it, 3);
 
     ecs_entity_t ecs_typeid(Sdl2Window) = ecs_lookup_fullpath(world, "system.sdl2.Window");
 
@@ -673,38 +1012,112 @@ void AttachRenderer(ecs_iter_t* it)
         const Sdl2Window* window = ecs_get(world, config->e_window, Sdl2Window);
 
         SDL_Window* sdl_window = window->window;
+        SDL_GLContext gl = SDL_GL_GetCurrentContext();
 
         sg_setup(&(sg_desc){0});
         TX_ASSERT(sg_isvalid());
         ecs_trace_1("sokol initialized");
 
+        sprite_instance_format instance_format = config[i].instance_format;
+
         struct sprite* sprites = NULL;
-        arrsetcap(sprites, 256);
+        struct sprite_compact* compact_sprites = NULL;
+        if (instance_format == SpriteInstanceFormat_Compact) {
+            arrsetcap(compact_sprites, 256);
+        } else {
+            arrsetcap(sprites, 256);
+        }
 
-        struct prim_line* lines = NULL;
-        arrsetcap(lines, 256);
+        struct prim_quad* prims = NULL;
+        arrsetcap(prims, K_PRIM_INITIAL_QUADS);
 
-        struct prim_rect* rects = NULL;
-        uint32_t* rect_indices = NULL;
-        arrsetcap(rects, 256);
-        arrsetcap(rect_indices, 256 * 6);
+        struct atlas_blob atlas_blob;
+        struct atlas_blob_sprite* atlas_sprites = NULL;
+        if (config[i].atlas_blob) {
+            tx_result blob_result = atlas_blob_load(config[i].atlas_blob, &atlas_blob);
+            TX_ASSERT(blob_result == TX_SUCCESS);
 
+            arrsetlen(atlas_sprites, atlas_blob.header.sprite_count);
+            memcpy(
+                atlas_sprites,
+                atlas_blob.sprites,
+                sizeof(struct atlas_blob_sprite) * atlas_blob.header.sprite_count);
+        }
+
+        const int initial_cap = 256;
         renderer_resources resources = init_renderer_resources(
-            sdl_window, (int)arrcap(sprites), config[i].canvas_width, config[i].canvas_height);
-        ecs_query_t* q_sprites =
-            ecs_query_new(world, "game.comp.Position, ANY:sprite.renderer.Sprite");
-        ecs_query_order_by(world, q_sprites, ecs_typeid(Sprite), compare_sprite_layers);
+            sdl_window,
+            initial_cap,
+            instance_format,
+            config[i].canvas_width,
+            config[i].canvas_height,
+            (config[i].atlas_blob) ? &atlas_blob : NULL);
+
+        if (config[i].atlas_blob) {
+            atlas_blob_free(&atlas_blob);
+        }
+
+        int32_t page_count = 0;
+        const char* pages[SPRITE_MAX_ATLAS_PAGES] = {"assets/atlas.png"};
+        while (page_count < SPRITE_MAX_ATLAS_PAGES && config[i].atlas_pages[page_count]) {
+            pages[page_count] = config[i].atlas_pages[page_count];
+            ++page_count;
+        }
+        page_count = (page_count) ? page_count : 1;
+
+        asset_handle atlas_pending = {0};
+        if (!config[i].atlas_blob) {
+            atlas_pending = asset_load_image_array(pages, page_count);
+        }
+
+        ecs_query_t* q_sprites = ecs_query_new(
+            world,
+            "game.comp.Position, ANY:sprite.renderer.Sprite, ?OWNED:sprite.renderer.SpriteColor, "
+            "?OWNED:sprite.renderer.SpriteAnimation");
+
+        int32_t anim_frame_count;
+        const struct sprite_anim_frame* anim_frames = sprite_anim_get_frames(&anim_frame_count);
+
+        vec4* anim_rects = NULL;
+        arrsetlen(anim_rects, anim_frame_count * 4);
+        for (int32_t f = 0; f < anim_frame_count; ++f) {
+            for (int32_t flip = 0; flip < 4; ++flip) {
+                anim_rects[f * 4 + flip] = spr_calc_rect(
+                    anim_frames[f].sprite_id,
+                    (sprite_flags)flip,
+                    anim_frames[f].width,
+                    anim_frames[f].height);
+            }
+        }
+
+        struct render_device* device = calloc(1, sizeof(struct render_device));
+        *device = (struct render_device){
+            .sdl_window = sdl_window,
+            .gl = gl,
+            .resources = resources,
+            .instance_format = instance_format,
+            .canvas_width = config[i].canvas_width,
+            .canvas_height = config[i].canvas_height,
+            .inst_vbuf_size = (int32_t)sprite_instance_size(instance_format) * initial_cap,
+            .prim_vbuf_size = (int32_t)sizeof(struct prim_quad) * K_PRIM_INITIAL_QUADS,
+        };
 
         ecs_singleton_set(
             world,
             Renderer,
             {
-                .resources = resources,
-                .sdl_window = sdl_window,
+                .device = device,
+                .instance_format = instance_format,
+                .present_mode = config[i].present_mode,
+                .skip_unchanged_canvas = config[i].skip_unchanged_canvas,
                 .sprites = sprites,
-                .lines = lines,
-                .rects = rects,
-                .rect_indices = rect_indices,
+                .compact_sprites = compact_sprites,
+                .prims = prims,
+                .anim_rects = anim_rects,
+                .atlas_sprites = atlas_sprites,
+                .atlas_page_count = page_count,
+                .atlas_blob_path = config[i].atlas_blob,
+                .atlas_pending = atlas_pending,
                 .pixels_per_meter = config[i].pixels_per_meter,
                 .canvas_width = config[i].canvas_width,
                 .canvas_height = config[i].canvas_height,
@@ -713,216 +1126,1048 @@ void AttachRenderer(ecs_iter_t* it)
                     {
                         .prim_layer = 0,
                     },
+                .q_cameras = ecs_query_new(world, "sprite.renderer.CameraView"),
+                .cull_enabled = true,
+                .sprite_tint = true,
+                .parallel_gather = jobs_worker_count() > 0,
             });
+
+        Renderer* r = ecs_singleton_get_mut(world, Renderer);
+        memcpy(r->atlas_pages, pages, sizeof(pages));
+        renderer_watch_files(r);
+
+        struct frame_mailbox* frames = &device->frames;
+        frames->write = 0;
+        frames->read = 1;
+        SDL_AtomicSet(&frames->ready, 2);
+        frames->published = SDL_CreateSemaphore(0);
+        frames->acquired = SDL_CreateSemaphore(0);
+
+        // The context can only be current on one thread. From here on every sokol call is made on
+        // the render thread and everything else that needs the context goes through render_cmds.
+#if !CRYPT_HEADLESS
+        SDL_GL_MakeCurrent(sdl_window, NULL);
+#endif
+        render_cmds_set_deferred(true);
+        device->thread = SDL_CreateThread(render_thread_main, "render", device);
+        TX_ASSERT(device->thread);
     }
 }
 
 void DetachRenderer(ecs_iter_t* it)
 {
     Renderer* r = ecs_term(it, Renderer, 1);
+    struct render_device* device = r->device;
+    struct frame_mailbox* frames = &device->frames;
+
+    // woken without a fresh packet the render thread exits, after drawing the last one
+    SDL_SemPost(frames->published);
+    SDL_WaitThread(device->thread, NULL);
+#if !CRYPT_HEADLESS
+    SDL_GL_MakeCurrent(device->sdl_window, device->gl);
+#endif
+
+    // anything recorded since the last packet was published, the releases below run right away
+    render_cmds_set_deferred(false);
 
     arrfree(r->sprites);
-    arrfree(r->lines);
-    arrfree(r->rects);
-    arrfree(r->rect_indices);
+    arrfree(r->compact_sprites);
+    arrfree(r->prims);
+    arrfree(r->anim_rects);
+    arrfree(r->atlas_sprites);
+
+    for (int32_t i = 0; i < K_FRAME_PACKETS; ++i) {
+        struct frame_packet* packet = &frames->packets[i];
+        arrfree(packet->sprites);
+        arrfree(packet->compact_sprites);
+        arrfree(packet->prims);
+        for (int32_t stage = 0; stage < RenderCmdStage_Count; ++stage) {
+            render_cmd_list_free(&packet->cmds[stage]);
+        }
+    }
+
+    // the asset owns the atlas once it has been swapped in
+    if (r->atlas_asset.id) {
+        asset_release(r->atlas_asset);
+    }
+    if (r->atlas_pending.id) {
+        asset_release(r->atlas_pending);
+    }
+    arrfree(r->gather_batches);
 
     ecs_query_free(r->q_sprites);
+    ecs_query_free(r->q_cameras);
 
+    shader_cache_clear();
     sg_shutdown();
+
+    SDL_DestroySemaphore(frames->published);
+    SDL_DestroySemaphore(frames->acquired);
+    free(device);
 }
 
-void RendererNewFrame(ecs_iter_t* it)
+struct bind_atlas_cmd {
+    struct render_device* device;
+    sg_image atlas;
+    // the placeholder atlas isn't owned by an asset
+    bool destroy_current;
+};
+
+void bind_atlas(void* data)
 {
-    Renderer* r = ecs_term(it, Renderer, 1);
+    struct bind_atlas_cmd* cmd = data;
+    renderer_resources* res = &cmd->device->resources;
 
-    r->prev_sprite_cap = arrcap(r->sprites);
-    arrsetlen(r->sprites, 0);
-    arrsetlen(r->lines, 0);
-    arrsetlen(r->rects, 0);
-    arrsetlen(r->rect_indices, 0);
+    if (cmd->destroy_current) {
+        sg_destroy_image(res->atlas);
+    }
+    res->atlas = cmd->atlas;
+    res->canvas.bindings.fs_images[0] = res->atlas;
 }
 
-void GatherSprites(ecs_iter_t* it)
+// Swaps in streamed atlas pages once they're uploaded. A failed load keeps whatever atlas is
+// currently bound.
+void renderer_swap_atlas(Renderer* r)
 {
-    Renderer* r = try_get_r();
-
-    Position* pos = ecs_term(it, Position, 1);
-    Sprite* spr = ecs_term(it, Sprite, 2);
-    SpriteColor* col = ecs_term(it, SpriteColor, 3);
+    if (!r->atlas_pending.id) {
+        return;
+    }
 
-    if (ecs_is_owned(it, 2)) {
-        for (int32_t i = 0; i < it->count; ++i) {
-            uint32_t sprite_id = spr[i].sprite_id;
-            float layer = spr[i].layer;
-            vec2 origin = spr[i].origin;
-            uint16_t flags = spr[i].flags;
-            uint16_t swidth = spr[i].width;
-            uint16_t sheight = spr[i].height;
-
-            vec3 position = (vec3){.x = pos[i].x, .y = pos[i].y, .z = -layer};
-
-            vec4 color = k_color_clear;
-            if (col) {
-                color = col[i].color;
-            }
+    asset_state state = asset_get_state(r->atlas_pending);
+    if (state == AssetState_Ready) {
+        // rebinding is recorded ahead of the release so the old image goes after it's unbound
+        render_cmd_push(
+            RenderCmdStage_Frame,
+            bind_atlas,
+            &(struct bind_atlas_cmd){
+                .device = r->device,
+                .atlas = asset_get_image(r->atlas_pending),
+                .destroy_current = !r->atlas_asset.id,
+            },
+            sizeof(struct bind_atlas_cmd));
 
-            arrpush(
-                r->sprites,
-                ((struct sprite){
-                    .pos = position,
-                    .rect = spr_calc_rect(sprite_id, flags, swidth, sheight),
-                    .scale = {.x = (float)swidth, .y = (float)sheight},
-                    .origin = origin,
-                    .color = color,
-                }));
+        if (r->atlas_asset.id) {
+            asset_release(r->atlas_asset);
         }
+        r->atlas_asset = r->atlas_pending;
+    } else if (state == AssetState_Failed) {
+        ecs_os_err("failed to load the sprite atlas, keeping the current one");
+        asset_release(r->atlas_pending);
     } else {
-        uint32_t sprite_id = spr->sprite_id;
-        float layer = spr->layer;
-        vec2 origin = spr->origin;
-        uint16_t flags = spr->flags;
-        uint16_t swidth = spr->width;
-        uint16_t sheight = spr->height;
+        return;
+    }
 
-        for (int32_t i = 0; i < it->count; ++i) {
-            vec3 position = (vec3){.x = pos[i].x, .y = pos[i].y, .z = -layer};
+    r->atlas_pending = (asset_handle){0};
+}
 
-            vec4 color = k_color_clear;
-            if (col) {
-                color = col[i].color;
-            }
+void renderer_watch_files(Renderer* r)
+{
+    r->hot_reload.enabled = true;
 
-            arrpush(
-                r->sprites,
-                ((struct sprite){
-                    .pos = position,
-                    .rect = spr_calc_rect(sprite_id, flags, swidth, sheight),
-                    .scale = {.x = (float)swidth, .y = (float)sheight},
-                    .origin = origin,
-                    .color = color,
-                }));
+    r->hot_reload.sprite_shader[0] = file_watch_add(sprite_vs_filename(r->instance_format));
+    r->hot_reload.sprite_shader[1] = file_watch_add("assets/shaders/sprite.frag");
+    r->hot_reload.prim_shader[0] = file_watch_add("assets/shaders/primitive.vert");
+    r->hot_reload.prim_shader[1] = file_watch_add("assets/shaders/primitive.frag");
+    r->hot_reload.screen_shader[0] = file_watch_add("assets/shaders/fullscreen_quad.vert");
+    r->hot_reload.screen_shader[1] = file_watch_add("assets/shaders/fullscreen_quad.frag");
+
+    for (int32_t i = 0; i < SPRITE_MAX_ATLAS_PAGES; ++i) {
+        r->hot_reload.atlas[i] = -1;
+    }
+
+    if (r->atlas_blob_path) {
+        r->hot_reload.atlas[0] = file_watch_add(r->atlas_blob_path);
+    } else {
+        for (int32_t i = 0; i < r->atlas_page_count; ++i) {
+            r->hot_reload.atlas[i] = file_watch_add(r->atlas_pages[i]);
         }
     }
 }
 
-#include "tx_input.h"
+// Arguments of the shader rebuild commands, tint only applies to the sprite shader.
+struct rebuild_shader_cmd {
+    struct render_device* device;
+    bool tint;
+};
 
-int sprite_cmp(const void* a, const void* b)
+void rebuild_sprite_shader(void* data)
 {
-    struct sprite* s0 = (struct sprite*)a;
-    struct sprite* s1 = (struct sprite*)b;
-    if (s0->pos.z < s1->pos.z) {
-        return -1;
-    } else if (s0->pos.z > s1->pos.z) {
-        return 1;
-    } else {
-        return 0;
+    struct rebuild_shader_cmd* cmd = data;
+    struct render_device* device = cmd->device;
+    renderer_resources* res = &device->resources;
+
+    sg_shader shader = make_sprite_shader(device->instance_format, cmd->tint);
+    if (try_replace_shader(&res->canvas.sprite_shader, shader, "sprite")) {
+        sg_destroy_pipeline(res->canvas.pip);
+        res->canvas.pip = make_sprite_pipeline(res->canvas.sprite_shader, device->instance_format);
     }
 }
 
-void Render(ecs_iter_t* it)
+void rebuild_prim_shader(void* data)
 {
-    ecs_world_t* world = it->world;
-    Renderer* r = ecs_term(it, Renderer, 1);
+    renderer_resources* res = &((struct rebuild_shader_cmd*)data)->device->resources;
 
-    size_t sprite_cap = arrcap(r->sprites);
-    if (sprite_cap > r->prev_sprite_cap) {
-        sg_destroy_buffer(r->resources.inst_vbuf);
+    if (try_replace_shader(&res->canvas.prim_shader, make_prim_shader(), "primitive")) {
+        sg_destroy_pipeline(res->canvas.prim_pip16);
+        sg_destroy_pipeline(res->canvas.prim_pip32);
+        make_prim_pipelines(
+            res->canvas.prim_shader, &res->canvas.prim_pip16, &res->canvas.prim_pip32);
+    }
+}
 
-        r->resources.inst_vbuf = sg_make_buffer(&(sg_buffer_desc){
-            .usage = SG_USAGE_STREAM,
-            .size = (int)(sizeof(struct sprite) * sprite_cap),
-        });
+void rebuild_screen_shader(void* data)
+{
+    renderer_resources* res = &((struct rebuild_shader_cmd*)data)->device->resources;
 
-        r->resources.canvas.bindings.vertex_buffers[1] = r->resources.inst_vbuf;
+    if (try_replace_shader(&res->screen.shader, make_screen_shader(), "fullscreen quad")) {
+        sg_destroy_pipeline(res->screen.pip);
+        res->screen.pip = make_screen_pipeline(res->screen.shader);
     }
+}
 
-    // qsort(r->sprites, arrlen(r->sprites), sizeof(struct sprite), sprite_cmp);
-
-    sg_update_buffer(
-        r->resources.inst_vbuf, r->sprites, (int)(sizeof(struct sprite) * arrlenu(r->sprites)));
+void push_rebuild_shader(Renderer* r, render_cmd_fn rebuild)
+{
+    render_cmd_push(
+        RenderCmdStage_Frame,
+        rebuild,
+        &(struct rebuild_shader_cmd){.device = r->device, .tint = r->sprite_tint},
+        sizeof(struct rebuild_shader_cmd));
+}
 
-    sg_update_buffer(
-        r->resources.line_vbuf, r->lines, (int)(sizeof(struct prim_line) * arrlenu(r->lines)));
+void renderer_rebuild_sprite_shader(Renderer* r)
+{
+    push_rebuild_shader(r, rebuild_sprite_shader);
+}
 
-    sg_update_buffer(
-        r->resources.rect_vbuf, r->rects, (int)(sizeof(struct prim_rect) * arrlenu(r->rects)));
+struct reload_atlas_blob_cmd {
+    struct render_device* device;
+    // freed once it's uploaded
+    struct atlas_blob atlas_blob;
+};
 
-    sg_update_buffer(
-        r->resources.rect_ibuf,
-        r->rect_indices,
-        (int)(sizeof(uint32_t) * arrlenu(r->rect_indices)));
+void reload_atlas_blob(void* data)
+{
+    struct reload_atlas_blob_cmd* cmd = data;
+    renderer_resources* res = &cmd->device->resources;
 
-    int width, height;
-    SDL_GL_GetDrawableSize(r->sdl_window, &width, &height);
+    sg_destroy_image(res->atlas);
+    res->atlas = make_atlas_blob_image(&cmd->atlas_blob);
+    res->canvas.bindings.fs_images[0] = res->atlas;
 
-    const float aspect = (float)r->canvas_width / r->canvas_height;
-    const float view_width = r->canvas_width / r->pixels_per_meter;
-    const float view_height = r->canvas_height / r->pixels_per_meter;
-    const float view_half_width = view_width / 2;
-    const float view_half_height = view_height / 2;
+    atlas_blob_free(&cmd->atlas_blob);
+}
 
-    static float cam_x = 0.0f;
-    static float cam_y = 0.0f;
-    static float cam_look_z = -1.0f;
+bool shader_files_changed(const int32_t watches[2])
+{
+    // both have to be checked to clear their changes
+    bool vs_changed = file_watch_changed(watches[0]);
+    bool fs_changed = file_watch_changed(watches[1]);
+    return vs_changed || fs_changed;
+}
 
-    if (txinp_get_key(TXINP_KEY_A)) cam_x -= 10.0f * it->delta_time;
-    if (txinp_get_key(TXINP_KEY_D)) cam_x += 10.0f * it->delta_time;
-    if (txinp_get_key(TXINP_KEY_W)) cam_y -= 10.0f * it->delta_time;
-    if (txinp_get_key(TXINP_KEY_S)) cam_y += 10.0f * it->delta_time;
+// Replaces the shader and its pipelines if the new shader compiled, otherwise the old ones are kept
+// and the new shader is thrown away.
+bool try_replace_shader(sg_shader* shader, sg_shader new_shader, const char* name)
+{
+    if (!shader_is_valid(new_shader)) {
+        ecs_os_err("%s shader failed to compile, keeping the previous one", name);
+        shader_cache_release(new_shader);
+        return false;
+    }
 
-    mat4 view =
-        mat4_look_at((vec3){cam_x, cam_y, 0}, (vec3){cam_x, cam_y, cam_look_z}, (vec3){0, 1, 0});
-    mat4 projection = mat4_ortho(
-        -view_half_width, view_half_width, view_half_height, -view_half_height, 0.0f, 1000.0f);
-    mat4 view_proj = mat4_mul(projection, view);
+    shader_cache_release(*shader);
+    *shader = new_shader;
+    ecs_trace_1("reloaded %s shader", name);
+    return true;
+}
 
-    // The first pass is the canvas pass which writes to the low resolution render target
-    sg_begin_pass(
-        r->resources.canvas.pass,
-        &(sg_pass_action){
-            .colors[0] =
-                {
-                    .action = SG_ACTION_CLEAR,
-                    // .val = {0.392f, 0.584f, 0.929f, 1.0f},
-                    .val = {0.1f, 0.1f, 0.1f, 1.0f},
-                },
-        });
+void renderer_hot_reload(Renderer* r)
+{
+    file_watch_update();
 
-    // same uniforms across all canvas renders
-    uniform_block uniforms = {.view_proj = view_proj};
-
-    // primtive rects
-    sg_apply_pipeline(r->resources.canvas.rect_pip);
-    sg_apply_bindings(&r->resources.canvas.rect_bindings);
-    sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, &uniforms, sizeof(uniform_block));
-    int rect_idx_ct = (int)arrlen(r->rect_indices);
-    int rect_ct = (int)arrlen(r->rects);
-    sg_draw(0, rect_idx_ct, rect_ct);
-
-    // primitive lines
-    sg_apply_pipeline(r->resources.canvas.line_pip);
-    sg_apply_bindings(&r->resources.canvas.line_bindings);
-    sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, &uniforms, sizeof(uniform_block));
-    int line_elems = (int)arrlen(r->lines);
-    sg_draw(0, line_elems * 2, line_elems);
-
-    // sprites
-    sg_apply_pipeline(r->resources.canvas.pip);
-    sg_apply_bindings(&r->resources.canvas.bindings);
-    sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, &uniforms, sizeof(uniform_block));
-    sg_draw(0, 6, (int)arrlen(r->sprites));
+    if (!r->hot_reload.enabled) {
+        return;
+    }
+
+    // the files are checked here, compiling and replacing happens on the render thread
+    if (shader_files_changed(r->hot_reload.sprite_shader)) {
+        push_rebuild_shader(r, rebuild_sprite_shader);
+    }
+    if (shader_files_changed(r->hot_reload.prim_shader)) {
+        push_rebuild_shader(r, rebuild_prim_shader);
+    }
+    if (shader_files_changed(r->hot_reload.screen_shader)) {
+        push_rebuild_shader(r, rebuild_screen_shader);
+    }
+
+    bool atlas_changed = false;
+    for (int32_t i = 0; i < SPRITE_MAX_ATLAS_PAGES; ++i) {
+        atlas_changed |= file_watch_changed(r->hot_reload.atlas[i]);
+    }
+
+    if (!atlas_changed) {
+        return;
+    }
+
+    if (r->atlas_blob_path) {
+        struct atlas_blob atlas_blob;
+        if (atlas_blob_load(r->atlas_blob_path, &atlas_blob) != TX_SUCCESS ||
+            atlas_blob.header.page_tiles != 16 ||
+            atlas_blob.header.page_count > SPRITE_MAX_ATLAS_PAGES) {
+            ecs_os_err("failed to reload %s, keeping the current atlas", r->atlas_blob_path);
+            return;
+        }
+
+        arrsetlen(r->atlas_sprites, atlas_blob.header.sprite_count);
+        memcpy(
+            r->atlas_sprites,
+            atlas_blob.sprites,
+            sizeof(struct atlas_blob_sprite) * atlas_blob.header.sprite_count);
+
+        render_cmd_push(
+            RenderCmdStage_Frame,
+            reload_atlas_blob,
+            &(struct reload_atlas_blob_cmd){.device = r->device, .atlas_blob = atlas_blob},
+            sizeof(struct reload_atlas_blob_cmd));
+    } else if (!r->atlas_pending.id) {
+        // stream the pages in again, the current atlas stays bound until they're ready
+        r->atlas_pending = asset_reload(r->atlas_asset);
+    }
+}
+
+// Without any camera the canvas shows the world around the origin.
+void calc_default_camera_view(const Renderer* r, CameraView* view)
+{
+    calc_camera_view(r, (vec2){0.0f, 0.0f}, 1.0f, (vec4){0.0f, 0.0f, 1.0f, 1.0f}, view);
+}
+
+struct view_rect calc_cull_rect(Renderer* r)
+{
+    struct view_rect rect = {FLT_MAX, -FLT_MAX, FLT_MAX, -FLT_MAX};
+    bool any_camera = false;
+
+    ecs_iter_t qit = ecs_query_iter(r->q_cameras);
+    while (ecs_query_next(&qit)) {
+        const CameraView* views = ecs_term(&qit, CameraView, 1);
+        for (int32_t i = 0; i < qit.count; ++i) {
+            rect.left = fminf(rect.left, views[i].visible.left);
+            rect.right = fmaxf(rect.right, views[i].visible.right);
+            rect.top = fminf(rect.top, views[i].visible.top);
+            rect.bottom = fmaxf(rect.bottom, views[i].visible.bottom);
+            any_camera = true;
+        }
+    }
+
+    if (!any_camera) {
+        CameraView view;
+        calc_default_camera_view(r, &view);
+        rect = view.visible;
+    }
+
+    return rect;
+}
+
+void push_gauge(ecs_gauge_t* gauge, int32_t t, float value)
+{
+    gauge->avg[t] = value;
+    gauge->min[t] = value;
+    gauge->max[t] = value;
+}
+
+void record_render_stats(Renderer* r, const struct render_stats* stats)
+{
+    struct render_stats_history* history = &r->stats_history;
+    int32_t t = (history->t + 1) % ECS_STAT_WINDOW;
+    history->t = t;
+
+    push_gauge(&history->gather_ms, t, stats->gather_ms);
+    push_gauge(&history->upload_ms, t, stats->upload_ms);
+    push_gauge(&history->submit_ms, t, stats->submit_ms);
+    push_gauge(
+        &history->upload_kb, t, (stats->inst_upload_bytes + stats->prim_upload_bytes) / 1024.0f);
+    push_gauge(&history->draw_calls, t, (float)stats->draw_calls);
+
+    // nothing has been submitted before the first frame
+    if (stats->draw_calls == 0) {
+        return;
+    }
+
+    // every field is summed, dividing by the frame count gives per frame averages
+    struct render_stats* total = &r->stats_total;
+    total->sprites_drawn += stats->sprites_drawn;
+    total->sprites_culled += stats->sprites_culled;
+    total->lines_drawn += stats->lines_drawn;
+    total->lines_culled += stats->lines_culled;
+    total->rects_drawn += stats->rects_drawn;
+    total->rects_culled += stats->rects_culled;
+    total->instance_bytes += stats->instance_bytes;
+    total->canvas_skips += stats->canvas_skips;
+    total->inst_upload_bytes += stats->inst_upload_bytes;
+    total->prim_upload_bytes += stats->prim_upload_bytes;
+    total->buffer_creates += stats->buffer_creates;
+    total->draw_calls += stats->draw_calls;
+    total->pipeline_switches += stats->pipeline_switches;
+    total->gather_ms += stats->gather_ms;
+    total->upload_ms += stats->upload_ms;
+    total->submit_ms += stats->submit_ms;
+    r->stats_frames++;
+}
+
+void sprite_renderer_dump_stats(FILE* out)
+{
+    const Renderer* r = try_get_r();
+    if (!r || r->stats_frames == 0) {
+        return;
+    }
+
+    const struct render_stats* total = &r->stats_total;
+    const double frames = (double)r->stats_frames;
+
+    fprintf(out, "render stats, per frame averages over %d frames\n", r->stats_frames);
+    fprintf(out, "  sprites drawn      %10.1f\n", total->sprites_drawn / frames);
+    fprintf(out, "  sprites culled     %10.1f\n", total->sprites_culled / frames);
+    fprintf(out, "  lines drawn        %10.1f\n", total->lines_drawn / frames);
+    fprintf(out, "  rects drawn        %10.1f\n", total->rects_drawn / frames);
+    fprintf(out, "  canvas skips       %10.3f\n", total->canvas_skips / frames);
+    fprintf(out, "  instance upload    %10.1f bytes\n", total->inst_upload_bytes / frames);
+    fprintf(out, "  primitive upload   %10.1f bytes\n", total->prim_upload_bytes / frames);
+    fprintf(out, "  buffer creates     %10.3f\n", total->buffer_creates / frames);
+    fprintf(out, "  draw calls         %10.1f\n", total->draw_calls / frames);
+    fprintf(out, "  pipeline switches  %10.1f\n", total->pipeline_switches / frames);
+    fprintf(out, "  gather             %10.4f ms\n", total->gather_ms / frames);
+    fprintf(out, "  upload             %10.4f ms\n", total->upload_ms / frames);
+    fprintf(out, "  submit             %10.4f ms\n", total->submit_ms / frames);
+}
+
+void RendererNewFrame(ecs_iter_t* it)
+{
+    Renderer* r = ecs_term(it, Renderer, 1);
+
+    arrsetlen(r->sprites, 0);
+    arrsetlen(r->compact_sprites, 0);
+    arrsetlen(r->prims, 0);
+
+    r->last_render_stats = r->render_stats;
+    memset(&r->render_stats, 0, sizeof(struct render_stats));
+    record_render_stats(r, &r->last_render_stats);
+
+    // cameras have already moved this frame so culling and rendering agree on the view
+    r->view = calc_cull_rect(r);
+
+    // Replacements are recorded as commands, the render thread runs them once it's done with the
+    // previous frame and before it draws this one.
+    renderer_hot_reload(r);
+    renderer_swap_atlas(r);
+}
+
+// Writes the visible sprites of a batch to whichever of out/out_compact is not NULL, returns the
+// number of sprites written.
+// Only reads from the batch and renderer so it is safe to run batches concurrently.
+int32_t gather_sprite_batch(
+    const Renderer* r,
+    const struct gather_batch* batch,
+    struct sprite* out,
+    struct sprite_compact* out_compact)
+{
+    const Position* pos = batch->pos;
+    const Sprite* spr = batch->spr;
+    const SpriteColor* col = batch->col;
+    const SpriteAnimation* anim = batch->anim;
+    const int32_t spr_stride = (batch->spr_owned) ? 1 : 0;
+
+    const struct sprite_anim_frame* anim_frames = sprite_anim_get_frames(NULL);
+
+    int32_t written = 0;
+    for (int32_t i = 0; i < batch->count; ++i) {
+        const Sprite* s = &spr[i * spr_stride];
+        uint32_t sprite_id = s->sprite_id;
+        float layer = s->layer;
+        vec2 origin = s->origin;
+        uint16_t flags = s->flags;
+        uint16_t swidth = s->width;
+        uint16_t sheight = s->height;
+
+        // animated sprites take their tile from the current frame, the Sprite is left untouched
+        if (anim) {
+            const struct sprite_anim_frame* frame = &anim_frames[anim[i].frame];
+            sprite_id = frame->sprite_id;
+            swidth = frame->width;
+            sheight = frame->height;
+        }
+
+        float x0 = pos[i].x - origin.x * swidth;
+        float y0 = pos[i].y - origin.y * sheight;
+        if (r->cull_enabled && !view_rect_overlaps(&r->view, x0, y0, x0 + swidth, y0 + sheight)) {
+            continue;
+        }
+
+        vec3 position = (vec3){.x = pos[i].x, .y = pos[i].y, .z = -layer};
+
+        vec4 color = k_color_clear;
+        if (col) {
+            color = col[i].color;
+        }
+
+        if (out_compact) {
+            out_compact[written++] =
+                pack_sprite_compact(position, sprite_id, flags, swidth, sheight, origin, color);
+        } else {
+            out[written++] = (struct sprite){
+                .pos = position,
+                .rect = (anim) ? r->anim_rects[anim[i].frame * 4 + (flags & 3)]
+                               : spr_calc_rect(sprite_id, flags, swidth, sheight),
+                .scale = {.x = (float)swidth, .y = (float)sheight},
+                .origin = origin,
+                .color = color,
+                .page = (float)(sprite_id / 256),
+            };
+        }
+    }
+
+    return written;
+}
+
+void gather_sprites_job(void* ctx, int32_t job_index)
+{
+    Renderer* r = (Renderer*)ctx;
+    struct gather_batch* batch = &r->gather_batches[job_index];
+
+    if (r->instance_format == SpriteInstanceFormat_Compact) {
+        batch->written =
+            gather_sprite_batch(r, batch, NULL, &r->compact_sprites[batch->offset]);
+    } else {
+        batch->written = gather_sprite_batch(r, batch, &r->sprites[batch->offset], NULL);
+    }
+}
+
+int32_t sprite_instance_count(const Renderer* r)
+{
+    if (r->instance_format == SpriteInstanceFormat_Compact) {
+        return (int32_t)arrlen(r->compact_sprites);
+    }
+    return (int32_t)arrlen(r->sprites);
+}
+
+uint8_t* sprite_instance_data(const Renderer* r)
+{
+    if (r->instance_format == SpriteInstanceFormat_Compact) {
+        return (uint8_t*)r->compact_sprites;
+    }
+    return (uint8_t*)r->sprites;
+}
+
+void sprite_instance_setlen(Renderer* r, int32_t len)
+{
+    if (r->instance_format == SpriteInstanceFormat_Compact) {
+        arrsetlen(r->compact_sprites, len);
+    } else {
+        arrsetlen(r->sprites, len);
+    }
+}
+
+// Runs every recorded batch and compacts the results into r->sprites in batch order, the output
+// is identical whether the batches ran on the job pool or serially.
+int32_t gather_sprite_batches(Renderer* r, bool parallel)
+{
+    int32_t num_batches = (int32_t)arrlen(r->gather_batches);
+    if (num_batches == 0) {
+        sprite_instance_setlen(r, 0);
+        return 0;
+    }
+
+    // every batch gets a region big enough to hold all of its sprites
+    const struct gather_batch* last = &arrlast(r->gather_batches);
+    sprite_instance_setlen(r, last->offset + last->count);
+
+    if (parallel) {
+        jobs_run(gather_sprites_job, r, num_batches);
+    } else {
+        for (int32_t b = 0; b < num_batches; ++b) {
+            gather_sprites_job(r, b);
+        }
+    }
+
+    // close the gaps left by culled sprites, regions only ever move towards the front
+    const size_t inst_size = sprite_instance_size(r->instance_format);
+    uint8_t* instances = sprite_instance_data(r);
+
+    int32_t len = 0;
+    for (int32_t b = 0; b < num_batches; ++b) {
+        const struct gather_batch* batch = &r->gather_batches[b];
+        if (batch->offset != len && batch->written > 0) {
+            memmove(
+                instances + inst_size * len,
+                instances + inst_size * batch->offset,
+                inst_size * batch->written);
+        }
+        len += batch->written;
+    }
+
+    sprite_instance_setlen(r, len);
+
+    return len;
+}
+
+void GatherSprites(ecs_iter_t* it)
+{
+    Renderer* r = ecs_term(it, Renderer, 1);
+    const uint64_t gather_start = SDL_GetPerformanceCounter();
+
+    // Record the matched tables as batches on this thread, the query and component storage are
+    // only read after this so the batches can be gathered on any thread.
+    arrsetlen(r->gather_batches, 0);
+    int32_t total = 0;
+
+    ecs_iter_t qit = ecs_query_iter(r->q_sprites);
+    while (ecs_query_next(&qit)) {
+        const Position* pos = ecs_term(&qit, Position, 1);
+        const Sprite* spr = ecs_term(&qit, Sprite, 2);
+        const SpriteColor* col = ecs_term(&qit, SpriteColor, 3);
+        const SpriteAnimation* anim = ecs_term(&qit, SpriteAnimation, 4);
+        bool spr_owned = ecs_is_owned(&qit, 2);
+
+        for (int32_t first = 0; first < qit.count; first += K_GATHER_BATCH_SIZE) {
+            int32_t count = qit.count - first;
+            if (count > K_GATHER_BATCH_SIZE) {
+                count = K_GATHER_BATCH_SIZE;
+            }
+
+            arrput(
+                r->gather_batches,
+                ((struct gather_batch){
+                    .pos = &pos[first],
+                    .spr = (spr_owned) ? &spr[first] : spr,
+                    .col = (col) ? &col[first] : NULL,
+                    .anim = (anim) ? &anim[first] : NULL,
+                    .spr_owned = spr_owned,
+                    .count = count,
+                    .offset = total,
+                }));
+
+            total += count;
+        }
+    }
+
+    int32_t len = gather_sprite_batches(r, r->parallel_gather);
+
+#if _DEBUG
+    if (r->validate_gather) {
+        const size_t bytes = sprite_instance_size(r->instance_format) * len;
+        uint8_t* gathered = NULL;
+        arrsetlen(gathered, bytes);
+        memcpy(gathered, sprite_instance_data(r), bytes);
+
+        int32_t serial_len = gather_sprite_batches(r, false);
+        TX_ASSERT(serial_len == len);
+        TX_ASSERT(memcmp(gathered, sprite_instance_data(r), bytes) == 0);
+
+        arrfree(gathered);
+    }
+#endif
+
+    r->render_stats.sprites_drawn = len;
+    r->render_stats.sprites_culled = total - len;
+    r->render_stats.gather_ms = elapsed_ms(gather_start);
+}
+
+int sprite_cmp(const void* a, const void* b)
+{
+    struct sprite* s0 = (struct sprite*)a;
+    struct sprite* s1 = (struct sprite*)b;
+    if (s0->pos.z < s1->pos.z) {
+        return -1;
+    } else if (s0->pos.z > s1->pos.z) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+// Hashes the instances, primitives and views of a packet. The resources the canvas pass binds are
+// only known to the render thread, canvas_resource_hash adds them.
+uint32_t calc_canvas_hash(const Renderer* r, const struct frame_packet* packet)
+{
+    const void* inst_data = (r->instance_format == SpriteInstanceFormat_Compact)
+                                ? (const void*)packet->compact_sprites
+                                : (const void*)packet->sprites;
+    const size_t inst_bytes = sprite_instance_size(r->instance_format) * packet->sprite_count;
+
+    uint32_t hash = XXH32(packet->views, sizeof(struct packet_view) * packet->view_count, 0);
+    hash = XXH32(inst_data, inst_bytes, hash);
+    hash = XXH32(packet->prims, sizeof(struct prim_quad) * packet->prim_count, hash);
+
+    // 0 is reserved for "always draw"
+    return (hash) ? hash : 1;
+}
+
+// Folds the ids of the resources the canvas pass binds into a packet's canvas hash, those change
+// whenever the atlas or a canvas shader is replaced.
+uint32_t canvas_resource_hash(const struct render_device* device, uint32_t canvas_hash)
+{
+    if (!canvas_hash) {
+        return 0;
+    }
+
+    const renderer_resources* res = &device->resources;
+    const uint32_t resource_ids[4] = {
+        res->atlas.id,
+        res->canvas.pip.id,
+        res->canvas.prim_pip16.id,
+        res->canvas.prim_pip32.id,
+    };
+
+    uint32_t hash = XXH32(resource_ids, sizeof(resource_ids), canvas_hash);
+    return (hash) ? hash : 1;
+}
+
+// Returns the window area the canvas is presented to.
+void calc_present_viewport(
+    const struct render_device* device,
+    sprite_present_mode present_mode,
+    int width,
+    int height,
+    int viewport[4])
+{
+    int scale = 0;
+    if (present_mode == SpritePresentMode_IntegerScale) {
+        int scale_x = width / (int)device->canvas_width;
+        int scale_y = height / (int)device->canvas_height;
+        scale = (scale_x < scale_y) ? scale_x : scale_y;
+    }
+
+    // windows smaller than the canvas fall back to stretching
+    if (scale < 1) {
+        viewport[0] = 0;
+        viewport[1] = 0;
+        viewport[2] = width;
+        viewport[3] = height;
+        return;
+    }
+
+    viewport[2] = (int)device->canvas_width * scale;
+    viewport[3] = (int)device->canvas_height * scale;
+    viewport[0] = (width - viewport[2]) / 2;
+    viewport[1] = (height - viewport[3]) / 2;
+}
+
+// Adds what the render thread counted for a packet, everything submit_frame_packet writes.
+void add_submit_stats(struct render_stats* stats, const struct render_stats* submit)
+{
+    stats->canvas_skips += submit->canvas_skips;
+    stats->inst_upload_bytes += submit->inst_upload_bytes;
+    stats->prim_upload_bytes += submit->prim_upload_bytes;
+    stats->buffer_creates += submit->buffer_creates;
+    stats->draw_calls += submit->draw_calls;
+    stats->pipeline_switches += submit->pipeline_switches;
+    stats->upload_ms += submit->upload_ms;
+    stats->submit_ms += submit->submit_ms;
+}
+
+// Hands this frame's instances, primitives and render commands over to the render thread. The
+// renderer gets the arrays of the packet that was drawn last in exchange, they're cleared in
+// RendererNewFrame. Returns once the render thread has taken the packet.
+void publish_frame_packet(Renderer* r)
+{
+    struct frame_mailbox* frames = &r->device->frames;
+    struct frame_packet* packet = &frames->packets[frames->write];
+
+    struct sprite* sprites = packet->sprites;
+    struct sprite_compact* compact_sprites = packet->compact_sprites;
+    struct prim_quad* prims = packet->prims;
+
+    packet->sprite_count = sprite_instance_count(r);
+    packet->prim_count = (int32_t)arrlen(r->prims);
+    packet->sprites = r->sprites;
+    packet->compact_sprites = r->compact_sprites;
+    packet->prims = r->prims;
+    packet->view_count = 0;
+
+    ecs_iter_t qit = ecs_query_iter(r->q_cameras);
+    while (ecs_query_next(&qit)) {
+        const CameraView* views = ecs_term(&qit, CameraView, 1);
+        for (int32_t i = 0; i < qit.count && packet->view_count < SPRITE_MAX_CAMERAS; ++i) {
+            struct packet_view* view = &packet->views[packet->view_count++];
+            view->view_proj = views[i].view_proj;
+            memcpy(view->viewport, views[i].viewport, sizeof(view->viewport));
+        }
+    }
+
+    if (packet->view_count == 0) {
+        CameraView default_view;
+        calc_default_camera_view(r, &default_view);
+        packet->views[0].view_proj = default_view.view_proj;
+        memcpy(packet->views[0].viewport, default_view.viewport, sizeof(default_view.viewport));
+        packet->view_count = 1;
+    }
+
+    r->sprites = sprites;
+    r->compact_sprites = compact_sprites;
+    r->prims = prims;
+
+    r->render_stats.instance_bytes =
+        (int32_t)sprite_instance_size(r->instance_format) * packet->sprite_count;
+    packet->canvas_hash = (r->skip_unchanged_canvas) ? calc_canvas_hash(r, packet) : 0;
+    packet->present_mode = r->present_mode;
+    render_cmds_take(packet->cmds);
+
+    // SDL_AtomicSet is a full barrier so the packet writes above are visible before it's parked.
+    // The render thread took the previous packet before the last publish returned, so the one
+    // parked here has been drawn.
+    int32_t parked = SDL_AtomicSet(&frames->ready, frames->write | K_FRAME_PACKET_FRESH);
+    frames->write = parked & ~K_FRAME_PACKET_FRESH;
+    SDL_SemPost(frames->published);
+
+    // the render thread's stats arrive with the packet, a frame or two after it was gathered
+    const struct frame_packet* drawn = &frames->packets[frames->write];
+    add_submit_stats(&r->render_stats, &drawn->stats);
+    if (drawn->stats.draw_calls) {
+        r->last_shader_stats = drawn->shader_stats;
+    }
+
+    SDL_SemWait(frames->acquired);
+}
+
+// Takes the newest packet and parks the one that was drawn for publish_frame_packet to reuse.
+struct frame_packet* acquire_frame_packet(struct frame_mailbox* frames)
+{
+    int32_t parked = SDL_AtomicSet(&frames->ready, frames->read);
+    frames->read = parked & ~K_FRAME_PACKET_FRESH;
+
+    return &frames->packets[frames->read];
+}
+
+// Uploads the packet's instances and primitives and draws them to the canvas image.
+void draw_canvas(
+    struct render_device* device, const struct frame_packet* packet, struct render_stats* stats)
+{
+    renderer_resources* res = &device->resources;
+    const uint64_t upload_start = SDL_GetPerformanceCounter();
+
+    const size_t inst_size = sprite_instance_size(device->instance_format);
+    const int32_t sprite_count = packet->sprite_count;
+    const int32_t inst_bytes = (int32_t)(inst_size * sprite_count);
+    const void* inst_data = (device->instance_format == SpriteInstanceFormat_Compact)
+                                ? (const void*)packet->compact_sprites
+                                : (const void*)packet->sprites;
+
+    if (inst_bytes > device->inst_vbuf_size) {
+        size_t sprite_cap = (device->instance_format == SpriteInstanceFormat_Compact)
+                                ? arrcap(packet->compact_sprites)
+                                : arrcap(packet->sprites);
+
+        sg_destroy_buffer(res->inst_vbuf);
+
+        device->inst_vbuf_size = (int32_t)(inst_size * sprite_cap);
+        res->inst_vbuf = sg_make_buffer(&(sg_buffer_desc){
+            .usage = SG_USAGE_STREAM,
+            .size = device->inst_vbuf_size,
+        });
+
+        res->canvas.bindings.vertex_buffers[1] = res->inst_vbuf;
+        stats->buffer_creates++;
+    }
+
+    // qsort(r->sprites, arrlen(r->sprites), sizeof(struct sprite), sprite_cmp);
+
+    sg_update_buffer(res->inst_vbuf, inst_data, inst_bytes);
+    stats->inst_upload_bytes += inst_bytes;
+
+    // the packets rotate their arrays, so the buffer is sized from whichever one is drawn
+    const int32_t prim_count = packet->prim_count;
+    const int32_t prim_bytes = (int32_t)sizeof(struct prim_quad) * prim_count;
+    if (prim_bytes > device->prim_vbuf_size) {
+        sg_destroy_buffer(res->prim_vbuf);
+
+        device->prim_vbuf_size = (int32_t)(sizeof(struct prim_quad) * arrcap(packet->prims));
+        res->prim_vbuf = sg_make_buffer(&(sg_buffer_desc){
+            .usage = SG_USAGE_STREAM,
+            .size = device->prim_vbuf_size,
+        });
+
+        res->canvas.prim_bindings.vertex_buffers[0] = res->prim_vbuf;
+        stats->buffer_creates++;
+    }
+
+    sg_update_buffer(res->prim_vbuf, packet->prims, prim_bytes);
+    stats->prim_upload_bytes += prim_bytes;
+
+    // Frames with more quads than 16-bit indices can address fall back to a 32-bit pattern, it
+    // only gets rebuilt when the quad count outgrows it.
+    const bool prim_wide_indices = prim_count > K_PRIM_MAX_QUADS_U16;
+    if (prim_wide_indices && prim_count > res->prim_ibuf32_quads) {
+        int32_t quads = (int32_t)arrcap(packet->prims);
+        uint32_t* indices = (uint32_t*)malloc(sizeof(uint32_t) * 6 * quads);
+        fill_quad_indices(indices, quads, true);
+
+        if (res->prim_ibuf32_quads > 0) {
+            sg_destroy_buffer(res->prim_ibuf32);
+        }
+        res->prim_ibuf32 = sg_make_buffer(&(sg_buffer_desc){
+            .type = SG_BUFFERTYPE_INDEXBUFFER,
+            .usage = SG_USAGE_IMMUTABLE,
+            .content = indices,
+            .size = (int)(sizeof(uint32_t) * 6 * quads),
+        });
+        res->prim_ibuf32_quads = quads;
+        stats->buffer_creates++;
+
+        free(indices);
+    }
+
+    stats->upload_ms += elapsed_ms(upload_start);
+
+    // The first pass is the canvas pass which writes to the low resolution render target
+    sg_begin_pass(
+        res->canvas.pass,
+        &(sg_pass_action){
+            .colors[0] =
+                {
+                    .action = SG_ACTION_CLEAR,
+                    // .val = {0.392f, 0.584f, 0.929f, 1.0f},
+                    .val = {0.1f, 0.1f, 0.1f, 1.0f},
+                },
+        });
+
+    // each camera draws the same buffers to its own part of the canvas
+    for (int32_t v = 0; v < packet->view_count; ++v) {
+        const struct packet_view* view = &packet->views[v];
+        sg_apply_viewport(
+            view->viewport[0], view->viewport[1], view->viewport[2], view->viewport[3], true);
+
+        uniform_block uniforms = {.view_proj = view->view_proj};
+
+        // primitives, lines and rects together
+        if (prim_count > 0) {
+            sg_bindings* prim_bindings = &res->canvas.prim_bindings;
+            if (prim_wide_indices) {
+                prim_bindings->index_buffer = res->prim_ibuf32;
+                sg_apply_pipeline(res->canvas.prim_pip32);
+            } else {
+                prim_bindings->index_buffer = res->prim_ibuf16;
+                sg_apply_pipeline(res->canvas.prim_pip16);
+            }
+            sg_apply_bindings(prim_bindings);
+            sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, &uniforms, sizeof(uniform_block));
+            sg_draw(0, prim_count * 6, 1);
+            stats->pipeline_switches++;
+            stats->draw_calls++;
+        }
+
+        // sprites
+        sg_apply_pipeline(res->canvas.pip);
+        sg_apply_bindings(&res->canvas.bindings);
+        sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, &uniforms, sizeof(uniform_block));
+        sg_draw(0, 6, sprite_count);
+        stats->pipeline_switches++;
+        stats->draw_calls++;
+    }
 
     sg_end_pass();
+}
+
+// Issues every sokol call for a frame on the render thread. Only the device and the packet are
+// touched here, none of the state the simulation writes to.
+void submit_frame_packet(struct render_device* device, struct frame_packet* packet)
+{
+    renderer_resources* res = &device->resources;
+    struct render_stats* stats = &packet->stats;
+    memset(stats, 0, sizeof(struct render_stats));
+    const uint64_t submit_start = SDL_GetPerformanceCounter();
+
+    // uploads and replacements recorded with the frame, they can change what the canvas pass binds
+    render_cmd_list_run(&packet->cmds[RenderCmdStage_Frame]);
+
+    // The canvas image keeps its contents between frames so an unchanged one is presented again.
+    // The screen pass still runs, the back buffer is undefined after a swap and imgui draws on top.
+    uint32_t canvas_hash = canvas_resource_hash(device, packet->canvas_hash);
+    if (!canvas_hash || canvas_hash != device->canvas_hash) {
+        draw_canvas(device, packet, stats);
+        device->canvas_hash = canvas_hash;
+    } else {
+        stats->canvas_skips++;
+    }
+
+    int width, height;
+    SDL_GL_GetDrawableSize(device->sdl_window, &width, &height);
+
+    int viewport[4];
+    calc_present_viewport(device, packet->present_mode, width, height, viewport);
 
-    // Render the canvas to the full screen window on a fullscreen quad
-    sg_begin_default_pass(&r->resources.screen.pass_action, width, height);
-    sg_apply_pipeline(r->resources.screen.pip);
-    sg_apply_bindings(&r->resources.screen.bindings);
+    // Render the canvas to the window on a fullscreen quad, the clear covers any letterboxing
+    sg_begin_default_pass(&res->screen.pass_action, width, height);
+    sg_apply_viewport(viewport[0], viewport[1], viewport[2], viewport[3], true);
+    sg_apply_pipeline(res->screen.pip);
+    sg_apply_bindings(&res->screen.bindings);
     sg_draw(0, 6, 1);
     sg_end_pass();
+    stats->pipeline_switches++;
+    stats->draw_calls++;
 
     sg_commit();
+
+    stats->submit_ms += elapsed_ms(submit_start) - stats->upload_ms;
+
+    // imgui draws straight to the back buffer once sokol is done with the frame
+    render_cmd_list_run(&packet->cmds[RenderCmdStage_Overlay]);
+
+#if !CRYPT_HEADLESS
+    SDL_GL_SwapWindow(device->sdl_window);
+#endif
+
+    struct packet_shader_stats* shader_stats = &packet->shader_stats;
+    shader_cache_get_stats(
+        &shader_stats->entries,
+        &shader_stats->hits,
+        &shader_stats->binary_loads,
+        &shader_stats->misses);
+}
+
+int render_thread_main(void* data)
+{
+    struct render_device* device = data;
+    struct frame_mailbox* frames = &device->frames;
+
+#if !CRYPT_HEADLESS
+    SDL_GL_MakeCurrent(device->sdl_window, device->gl);
+#endif
+
+    for (;;) {
+        SDL_SemWait(frames->published);
+
+        // every publish parks a fresh packet, DetachRenderer wakes the thread without one
+        if (!(SDL_AtomicGet(&frames->ready) & K_FRAME_PACKET_FRESH)) {
+            break;
+        }
+
+        struct frame_packet* packet = acquire_frame_packet(frames);
+        SDL_SemPost(frames->acquired);
+
+        submit_frame_packet(device, packet);
+    }
+
+#if !CRYPT_HEADLESS
+    SDL_GL_MakeCurrent(device->sdl_window, NULL);
+#endif
+
+    return 0;
+}
+
+// Runs in EcsPostFrame so everything recorded in the frame (imgui draws in EcsPostStore) goes out
+// with its packet. Drawing it overlaps with simulating the next frame.
+void Render(ecs_iter_t* it)
+{
+    Renderer* r = ecs_term(it, Renderer, 1);
+
+    publish_frame_packet(r);
+}
+
+void sprite_renderer_shutdown(ecs_world_t* world)
+{
+    // DetachRenderer runs as the singleton is removed
+    ecs_entity_t renderer = ecs_lookup_fullpath(world, "sprite.renderer.Renderer");
+    if (renderer) {
+        ecs_remove_id(world, EcsWorld, renderer);
+    }
 }
 
 void FixupSpriteSize(ecs_iter_t* it)
@@ -940,11 +2185,313 @@ void FixupSpriteSize(ecs_iter_t* it)
     }
 }
 
+bool sprite_atlas_find(const char* name, Sprite* sprite)
+{
+    Renderer* r = try_get_r();
+    if (!r) {
+        return false;
+    }
+
+    for (int32_t i = 0; i < arrlen(r->atlas_sprites); ++i) {
+        const struct atlas_blob_sprite* entry = &r->atlas_sprites[i];
+        if (strncmp(entry->name, name, ATLAS_BLOB_NAME_MAX) == 0) {
+            sprite->sprite_id = entry->sprite_id;
+            sprite->width = entry->width;
+            sprite->height = entry->height;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void fixup_sprite_animation(SpriteAnimation* anim, const struct sprite_anim_clip* clips,
+    int32_t clip_count)
+{
+    if (anim->clip >= clip_count) {
+        ecs_os_err("sprite animation clip %d doesn't exist", anim->clip);
+        anim->clip = 0;
+    }
+    // a zero speed is what ecs_set leaves behind when only the clip is given
+    anim->speed = (anim->speed != 0.0f) ? anim->speed : 1.0f;
+    anim->frame = (uint16_t)clips[anim->clip].first_frame;
+}
+
+void FixupSpriteAnimation(ecs_iter_t* it)
+{
+    SpriteAnimation* anim = ecs_term(it, SpriteAnimation, 1);
+
+    int32_t clip_count;
+    const struct sprite_anim_clip* clips = sprite_anim_get_clips(&clip_count);
+
+    if (!ecs_is_owned(it, 1)) {
+        if (clip_count > 0) {
+            fixup_sprite_animation(anim, clips, clip_count);
+        }
+        return;
+    }
+
+    // the advance and gather loops index the clip and frame tables without checking, without any
+    // clips the animation is dropped and the sprite keeps its own sprite_id
+    for (int32_t i = 0; i < it->count; ++i) {
+        if (clip_count == 0) {
+            ecs_remove_id(it->world, it->entities[i], ecs_term_id(it, 1));
+            continue;
+        }
+        fixup_sprite_animation(&anim[i], clips, clip_count);
+    }
+}
+
+// instances of a prefab get their own timeline, a shared one would never be advanced or gathered
+void CopySpriteAnimation(ecs_iter_t* it)
+{
+    SpriteAnimation* shared = ecs_term(it, SpriteAnimation, 1);
+    ecs_entity_t ecs_typeid(SpriteAnimation) = ecs_term_id(it, 1);
+
+    for (int32_t i = 0; i < it->count; ++i) {
+        ecs_set_ptr(it->world, it->entities[i], SpriteAnimation, shared);
+    }
+}
+
+void AdvanceSpriteAnimations(ecs_iter_t* it)
+{
+    SpriteAnimation* anim = ecs_term(it, SpriteAnimation, 1);
+
+    sprite_anim_advance(anim, it->count, it->delta_time);
+}
+
+void AttachCamera(ecs_iter_t* it)
+{
+    ecs_world_t* world = it->world;
+    Camera* camera = ecs_term(it, Camera, 1);
+    ecs_entity_t ecs_typeid(CameraView) = ecs_term_id(it, 2);
+
+    for (int32_t i = 0; i < it->count; ++i) {
+        camera[i].zoom = (camera[i].zoom > 0.0f) ? camera[i].zoom : 1.0f;
+
+        // zero inputs never match a camera so the view gets built on the next update
+        if (!ecs_has_id(world, it->entities[i], ecs_typeid(CameraView))) {
+            ecs_set(world, it->entities[i], CameraView, {0});
+        }
+    }
+}
+
+// Eases cameras towards their targets and keeps them inside their bounds, view_proj is only rebuilt
+// for cameras that moved, zoomed or changed viewport.
+void UpdateCameras(ecs_iter_t* it)
+{
+    Position* pos = ecs_term(it, Position, 1);
+    const Camera* camera = ecs_term(it, Camera, 2);
+    CameraView* view = ecs_term(it, CameraView, 3);
+
+    const Renderer* r = try_get_r();
+    if (!r) {
+        return;
+    }
+
+    for (int32_t i = 0; i < it->count; ++i) {
+        const Camera* cam = &camera[i];
+
+        float t = 1.0f - powf(cam->smoothing, it->delta_time);
+        pos[i].x += (cam->target.x - pos[i].x) * t;
+        pos[i].y += (cam->target.y - pos[i].y) * t;
+
+        int32_t viewport[4];
+        calc_camera_viewport(r, cam->viewport, viewport);
+        const float half_width = (viewport[2] / r->pixels_per_meter) * cam->zoom / 2;
+        const float half_height = (viewport[3] / r->pixels_per_meter) * cam->zoom / 2;
+
+        // a view bigger than its bounds stays centered on them
+        const view_rect* bounds = &cam->bounds;
+        if (bounds->right > bounds->left) {
+            pos[i].x = (bounds->right - bounds->left > half_width * 2)
+                           ? clampf(pos[i].x, bounds->left + half_width, bounds->right - half_width)
+                           : (bounds->left + bounds->right) / 2;
+        }
+        if (bounds->bottom > bounds->top) {
+            pos[i].y = (bounds->bottom - bounds->top > half_height * 2)
+                           ? clampf(pos[i].y, bounds->top + half_height, bounds->bottom - half_height)
+                           : (bounds->top + bounds->bottom) / 2;
+        }
+
+        if (view[i].pos.x == pos[i].x && view[i].pos.y == pos[i].y && view[i].zoom == cam->zoom &&
+            memcmp(&view[i].viewport_norm, &cam->viewport, sizeof(vec4)) == 0) {
+            continue;
+        }
+
+        calc_camera_view(r, pos[i], cam->zoom, cam->viewport, &view[i]);
+    }
+}
+
+typedef struct renderer_debug_gui_context {
+    int32_t dummy;
+} renderer_debug_gui_context;
+
+void renderer_debug_gui(ecs_world_t* world, void* ctx)
+{
+    Renderer* r = try_get_r();
+
+    if (!r) {
+        return;
+    }
+
+    igCheckbox("View Culling", &r->cull_enabled);
+    igCheckbox("Parallel Gather", &r->parallel_gather);
+    igCheckbox("Hot Reload", &r->hot_reload.enabled);
+    igCheckbox("Skip Unchanged Canvas", &r->skip_unchanged_canvas);
+    bool integer_scale = r->present_mode == SpritePresentMode_IntegerScale;
+    if (igCheckbox("Integer Scale", &integer_scale)) {
+        r->present_mode =
+            (integer_scale) ? SpritePresentMode_IntegerScale : SpritePresentMode_Stretch;
+    }
+    if (igCheckbox("Color Tint", &r->sprite_tint)) {
+        renderer_rebuild_sprite_shader(r);
+    }
+#if _DEBUG
+    igCheckbox("Validate Gather", &r->validate_gather);
+#endif
+    igLabelText("Job Workers", "%d", jobs_worker_count());
+    igLabelText(
+        "Cull Rect",
+        "%0.2f, %0.2f, %0.2f, %0.2f",
+        r->view.left,
+        r->view.top,
+        r->view.right,
+        r->view.bottom);
+
+    igSeparator();
+
+    const struct render_stats* stats = &r->last_render_stats;
+    igLabelText("Sprites", "%d drawn, %d culled", stats->sprites_drawn, stats->sprites_culled);
+    igLabelText("Lines", "%d drawn, %d culled", stats->lines_drawn, stats->lines_culled);
+    igLabelText("Rects", "%d drawn, %d culled", stats->rects_drawn, stats->rects_culled);
+
+    igSeparator();
+
+    igLabelText(
+        "Instance Format",
+        "%s (%d bytes)",
+        (r->instance_format == SpriteInstanceFormat_Compact) ? "Compact" : "Full",
+        (int32_t)sprite_instance_size(r->instance_format));
+    igLabelText("Instance Bytes/Frame", "%d", stats->instance_bytes);
+    igLabelText("Canvas Skipped", "%s", (stats->canvas_skips) ? "yes" : "no");
+
+    // the cache lives on the render thread, these come back with the drawn packets
+    const struct packet_shader_stats* shader_stats = &r->last_shader_stats;
+    igLabelText(
+        "Shader Cache",
+        "%d variants, %d hits, %d from disk, %d compiles",
+        shader_stats->entries,
+        shader_stats->hits,
+        shader_stats->binary_loads,
+        shader_stats->misses);
+}
+
+void render_stats_debug_gui(ecs_world_t* world, void* ctx)
+{
+    Renderer* r = try_get_r();
+
+    if (!r) {
+        return;
+    }
+
+    const struct render_stats* stats = &r->last_render_stats;
+    igLabelText("Gathered", "%d instances", stats->sprites_drawn);
+    igLabelText("Instance Upload", "%d bytes", stats->inst_upload_bytes);
+    igLabelText("Primitive Upload", "%d bytes", stats->prim_upload_bytes);
+    igLabelText("Buffer Creates", "%d", stats->buffer_creates);
+    igLabelText("Draw Calls", "%d", stats->draw_calls);
+    igLabelText("Pipeline Switches", "%d", stats->pipeline_switches);
+    igLabelText(
+        "CPU Time",
+        "gather %0.3fms, upload %0.3fms, submit %0.3fms",
+        stats->gather_ms,
+        stats->upload_ms,
+        stats->submit_ms);
+
+    const struct render_stats_history* history = &r->stats_history;
+    const ImVec2 plot_size = {600.f, 80.f};
+
+    plot_ecs_guage(
+        history->t,
+        &(struct gauge_plot_desc){
+            .title = "Gather (ms)",
+            .gauge = &history->gather_ms,
+            .size = plot_size,
+            .vmin = 0,
+            .vmax = 4.0f,
+            .markers = {[0] = {.value = 1.0f, .color = 0xFF00FFFF}},
+        });
+    plot_ecs_guage(
+        history->t,
+        &(struct gauge_plot_desc){
+            .title = "Upload (ms)",
+            .gauge = &history->upload_ms,
+            .size = plot_size,
+            .vmin = 0,
+            .vmax = 4.0f,
+            .markers = {[0] = {.value = 1.0f, .color = 0xFF00FFFF}},
+        });
+    plot_ecs_guage(
+        history->t,
+        &(struct gauge_plot_desc){
+            .title = "Submit (ms)",
+            .gauge = &history->submit_ms,
+            .size = plot_size,
+            .vmin = 0,
+            .vmax = 4.0f,
+            .markers = {[0] = {.value = 1.0f, .color = 0xFF00FFFF}},
+        });
+    plot_ecs_guage(
+        history->t,
+        &(struct gauge_plot_desc){
+            .title = "Upload (KB)",
+            .gauge = &history->upload_kb,
+            .size = plot_size,
+            .vmin = 0,
+            .vmax = 1024.0f,
+        });
+    plot_ecs_guage(
+        history->t,
+        &(struct gauge_plot_desc){
+            .title = "Draw Calls",
+            .gauge = &history->draw_calls,
+            .size = plot_size,
+            .vmin = 0,
+            .vmax = 16.0f,
+        });
+}
+
 void renderer_fini(ecs_world_t* world, void* ctx)
 {
     ecs_query_free(q_renderer);
+    sprite_anim_db_free();
 }
 
+static jsfield sprite_fields[] = {
+    JSFIELD_OBJECT(Sprite, origin, &scene_vec2_desc),
+    JSFIELD(JsField_Float, Sprite, layer),
+    JSFIELD(JsField_Int, Sprite, sprite_id),
+    JSFIELD(JsField_Int, Sprite, flags),
+    JSFIELD(JsField_Int, Sprite, width),
+    JSFIELD(JsField_Int, Sprite, height),
+};
+static jsobject_desc sprite_desc = JSOBJECT(sprite_fields);
+
+static jsfield camera_fields[] = {
+    JSFIELD_OBJECT(Camera, target, &scene_vec2_desc),
+    JSFIELD(JsField_Float, Camera, smoothing),
+    JSFIELD(JsField_Float, Camera, zoom),
+};
+static jsobject_desc camera_desc = JSOBJECT(camera_fields);
+
+static jsfield sprite_animation_fields[] = {
+    JSFIELD(JsField_Int, SpriteAnimation, clip),
+    JSFIELD(JsField_Float, SpriteAnimation, time),
+    JSFIELD(JsField_Float, SpriteAnimation, speed),
+};
+static jsobject_desc sprite_animation_desc = JSOBJECT(sprite_animation_fields);
+
 void SpriteRendererImport(ecs_world_t* world)
 {
     ECS_MODULE(world, SpriteRenderer);
@@ -952,13 +2499,28 @@ void SpriteRendererImport(ecs_world_t* world)
     ecs_atfini(world, renderer_fini, NULL);
 
     ECS_IMPORT(world, GameComp);
+    ECS_IMPORT(world, Assets);
 
     ECS_COMPONENT(world, Sprite);
     ECS_COMPONENT(world, SpriteColor);
+    ECS_COMPONENT(world, SpriteAnimation);
     ECS_COMPONENT(world, SpriteRenderConfig);
+    ECS_COMPONENT(world, Camera);
+    ECS_COMPONENT(world, CameraView);
+
+    SCENE_COMPONENT(world, Sprite, &sprite_desc);
+    SCENE_COMPONENT(world, Camera, &camera_desc);
+    SCENE_COMPONENT(world, SpriteAnimation, &sprite_animation_desc);
 
     ECS_COMPONENT(world, Renderer);
 
+    // clips have to be loaded before a renderer is attached, it bakes their frame rects
+    tx_result anim_result = sprite_anim_db_load("assets/sprite_anims.json");
+    if (anim_result != TX_SUCCESS) {
+        ecs_os_err("failed to load assets/sprite_anims.json, sprites won't animate");
+    }
+    TX_ASSERT(anim_result == TX_SUCCESS);
+
     // clang-format off
     ECS_SYSTEM(world, AttachRenderer, EcsOnSet,
         [in] SpriteRenderConfig,
@@ -966,17 +2528,44 @@ void SpriteRendererImport(ecs_world_t* world)
         :Sprite);
     ECS_SYSTEM(world, DetachRenderer, EcsUnSet, Renderer);
 
+    ECS_SYSTEM(world, AttachCamera, EcsOnSet, Camera, [out] :CameraView);
+    ECS_SYSTEM(world, UpdateCameras, EcsPostLoad, game.comp.Position, [in] Camera, CameraView);
+
     ECS_SYSTEM(world, RendererNewFrame, EcsPostLoad, Renderer);
-    ECS_SYSTEM(world, GatherSprites, EcsPreStore,
-        game.comp.Position, ANY:Sprite, ?OWNED:SpriteColor);
-    ECS_SYSTEM(world, Render, EcsOnStore, Renderer);
+    ECS_SYSTEM(world, GatherSprites, EcsPreStore, Renderer);
+    ECS_SYSTEM(world, Render, EcsPostFrame, Renderer);
 
     ECS_SYSTEM(world, FixupSpriteSize, EcsOnSet, Sprite)
+    ECS_SYSTEM(world, FixupSpriteAnimation, EcsOnSet, SpriteAnimation);
+    ECS_SYSTEM(world, CopySpriteAnimation, EcsOnSet, SHARED:SpriteAnimation);
+    ECS_SYSTEM(world, AdvanceSpriteAnimations, EcsPostUpdate, OWNED:SpriteAnimation);
     // clang-format on
 
     q_renderer = ecs_query_new(world, "$sprite.renderer.Renderer");
 
+    ECS_IMPORT(world, DebugGui);
+
+    DEBUG_PANEL(
+        world,
+        RendererDebug,
+        ImGuiWindowFlags_None,
+        "shift+4",
+        renderer_debug_gui,
+        renderer_debug_gui_context,
+        {0});
+    DEBUG_PANEL(
+        world,
+        RenderStats,
+        ImGuiWindowFlags_None,
+        "shift+5",
+        render_stats_debug_gui,
+        renderer_debug_gui_context,
+        {0});
+
     ECS_EXPORT_COMPONENT(Sprite);
     ECS_EXPORT_COMPONENT(SpriteColor);
+    ECS_EXPORT_COMPONENT(SpriteAnimation);
     ECS_EXPORT_COMPONENT(SpriteRenderConfig);
+    ECS_EXPORT_COMPONENT(Camera);
+    ECS_EXPORT_COMPONENT(CameraView);
 }
\ No newline at end of file
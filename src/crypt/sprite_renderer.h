@@ -1,10 +1,13 @@
 #pragma once
 
+#include "atlas_blob.h"
 #include "color.h"
 #include "flecs.h"
 #include "sokol_gfx.h"
+#include "sprite_anim.h"
 #include "tx_math.h"
 #include "tx_types.h"
+#include <stdio.h>
 
 void draw_line(vec2 from, vec2 to);
 void draw_line_col(vec2 from, vec2 to, vec4 col);
@@ -28,6 +31,10 @@ typedef enum sprite_flags {
     SpriteFlags_FlipY = 2,
 } sprite_flags;
 
+// Atlas pages are 16x16 tiles each and are bound together as one texture array, a sprite_id
+// addresses tiles across all pages: page = sprite_id / 256.
+enum { SPRITE_MAX_ATLAS_PAGES = 8 };
+
 typedef struct Sprite {
     vec2 origin;
     float layer;
@@ -41,22 +48,98 @@ typedef struct SpriteColor {
     vec4 color;
 } SpriteColor;
 
+typedef enum sprite_instance_format {
+    // 64 bytes per sprite, everything as floats
+    SpriteInstanceFormat_Full = 0,
+    // 24 bytes per sprite, atlas tile coordinates, origin and color are quantized
+    SpriteInstanceFormat_Compact = 1,
+} sprite_instance_format;
+
+typedef enum sprite_present_mode {
+    // canvas is stretched over the whole window
+    SpritePresentMode_Stretch = 0,
+    // canvas is scaled by the largest whole factor that fits and centered, the rest is cleared
+    SpritePresentMode_IntegerScale = 1,
+} sprite_present_mode;
+
 typedef struct SpriteRenderConfig {
+    sprite_instance_format instance_format;
+    sprite_present_mode present_mode;
+    // skip the canvas pass on frames that would draw exactly what the canvas already holds
+    bool skip_unchanged_canvas;
     float pixels_per_meter;
     uint32_t canvas_width;
     uint32_t canvas_height;
     ecs_entity_t e_window;
+    // image files for each atlas page, all pages must be the same size. Defaults to
+    // assets/atlas.png when no pages are given.
+    const char* atlas_pages[SPRITE_MAX_ATLAS_PAGES];
+    // packed atlas written by atlas_packer, used instead of atlas_pages when set
+    const char* atlas_blob;
 } SpriteRenderConfig;
 
+// world space rectangle, y grows downwards like the rest of the game
+typedef struct view_rect {
+    float left, right;
+    float top, bottom;
+} view_rect;
+
+enum { SPRITE_MAX_CAMERAS = 4 };
+
+// A view into the world drawn to a region of the canvas, the view is centered on the entity's
+// Position. Every camera draws the same gathered sprites and primitives so split-screen and
+// minimap views don't gather anything twice. Viewports shouldn't overlap, all cameras share the
+// canvas depth buffer.
+typedef struct Camera {
+    // Position eases towards the target, set both to snap
+    vec2 target;
+    // fraction of the distance to the target that is left after a second, 0 snaps
+    float smoothing;
+    // 2 shows twice as much of the world, defaults to 1
+    float zoom;
+    // the visible rectangle is kept inside these bounds unless they're empty
+    view_rect bounds;
+    // normalized x, y, width, height of the canvas to draw to, defaults to the whole canvas
+    vec4 viewport;
+} Camera;
+
+// Written by the renderer from Camera, read it to find out what a camera can see.
+typedef struct CameraView {
+    mat4 view_proj;
+    view_rect visible;
+    // canvas pixels, x, y, width, height with the origin in the top left
+    int32_t viewport[4];
+    // what view_proj was built from, it's only rebuilt when one of these changes
+    vec2 pos;
+    float zoom;
+    vec4 viewport_norm;
+} CameraView;
+
 typedef struct SpriteRenderer {
     ECS_DECLARE_COMPONENT(Sprite);
     ECS_DECLARE_COMPONENT(SpriteColor);
+    ECS_DECLARE_COMPONENT(SpriteAnimation);
     ECS_DECLARE_COMPONENT(SpriteRenderConfig);
+    ECS_DECLARE_COMPONENT(Camera);
+    ECS_DECLARE_COMPONENT(CameraView);
 } SpriteRenderer;
 
+// Looks up a sprite packed into the atlas blob by name and fills in its sprite_id and size.
+bool sprite_atlas_find(const char* name, Sprite* sprite);
+
+// Writes per frame averages of the renderer's CPU side stats since it was attached.
+void sprite_renderer_dump_stats(FILE* out);
+
+// Stops the render thread and releases the renderer. Call it before ecs_fini, the render thread
+// draws to the window that system.sdl2 destroys while the world is torn down.
+void sprite_renderer_shutdown(ecs_world_t* world);
+
 void SpriteRendererImport(ecs_world_t* world);
 
 #define SpriteRendererImportHandles(handles)                                                       \
     ECS_IMPORT_COMPONENT(handles, Sprite);                                                         \
     ECS_IMPORT_COMPONENT(handles, SpriteColor);                                                    \
-    ECS_IMPORT_COMPONENT(handles, SpriteRenderConfig);
+    ECS_IMPORT_COMPONENT(handles, SpriteAnimation);                                                \
+    ECS_IMPORT_COMPONENT(handles, SpriteRenderConfig);                                             \
+    ECS_IMPORT_COMPONENT(handles, Camera);                                                         \
+    ECS_IMPORT_COMPONENT(handles, CameraView);
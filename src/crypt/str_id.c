@@ -1,4 +1,5 @@
 #include "str_id.h"
+#include "hash.h"
 #include "string.h"
 #include "strpool.h"
 
@@ -27,6 +28,7 @@ str_id str_id_store_w_len(const char* str, int len)
 {
     return (str_id){
         .value = strpool_inject(&pool, str, len),
+        .hash = hash_data(str, len),
     };
 }
 
@@ -39,3 +41,8 @@ const char* str_id_cstr(str_id id)
 {
     return strpool_cstr(&pool, (uint64_t)id.value);
 }
+
+bool str_id_matches(str_id id, const char* str, uint32_t hash)
+{
+    return id.hash == hash && strcmp(str_id_cstr(id), str) == 0;
+}
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
+// Interned strings, storing the same text twice gives back the same handle so ids compare with a
+// single integer compare. The hash of the text (hash.h's hash_string) is kept alongside so tables
+// keyed by strings can be searched with a raw const char* by hashing it once and comparing hashes,
+// only falling back to strcmp on a match.
 typedef struct str_id {
     uint64_t value;
+    uint32_t hash;
 } str_id;
 
 extern str_id str_id_empty;
@@ -14,4 +20,23 @@ void str_id_term();
 str_id str_id_store(const char* str);
 str_id str_id_store_w_len(const char* str, int len);
 void str_id_release(str_id id);
-const char* str_id_cstr(str_id id);
\ No newline at end of file
+const char* str_id_cstr(str_id id);
+
+static inline bool str_id_eq(str_id a, str_id b)
+{
+    return a.value == b.value;
+}
+
+// Whether id holds str, hash is hash_string(str) so it can be computed once for a whole search.
+bool str_id_matches(str_id id, const char* str, uint32_t hash);
+
+// Symbols for literals used by code, declared like flecs components and stored once by
+// STR_ID_DEFINE after str_id_init. After that STR_ID(name) is a plain load, no hashing or
+// interning on use.
+//   STR_ID_DECLARE(InvaderRoot);       file scope, or extern in a header with STR_ID_EXTERN
+//   STR_ID_DEFINE(InvaderRoot);        once during startup
+//   STR_ID(InvaderRoot)                "InvaderRoot"
+#define STR_ID(name) str_id_sym_##name
+#define STR_ID_DECLARE(name) str_id STR_ID(name)
+#define STR_ID_EXTERN(name) extern str_id STR_ID(name)
+#define STR_ID_DEFINE(name) STR_ID(name) = str_id_store(#name)
@@ -1,9 +1,12 @@
 #include "system_imgui.h"
+#include "render_cmds.h"
 #include "sprite_renderer.h"
 #include "system_sdl2.h"
 #include <SDL2/SDL.h>
 #include <ccimgui.h>
 #include <cimgui_impl.h>
+#include <stdlib.h>
+#include <string.h>
 
 static void AttachImgui(ecs_iter_t* it)
 {
@@ -19,12 +22,23 @@ static void AttachImgui(ecs_iter_t* it)
     ImGuiIO* imgui = igGetIO();
     imgui->ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
     ImGui_ImplSDL2_InitForOpenGL(window->window, gl->gl);
+#if !CRYPT_HEADLESS
     ImGui_ImplOpenGL3_Init(NULL);
+#endif
     igStyleColorsDark(NULL);
 
     ImFont* editor_font = ImFontAtlas_AddFontFromFileTTF(
         imgui->Fonts, "assets/fonts/FiraCode-Regular.ttf", 24.0f, NULL, NULL);
 
+#if CRYPT_HEADLESS
+    // the OpenGL backend normally builds the font atlas, debug panels still run without it
+    ImFontAtlas_Build(imgui->Fonts);
+#else
+    // Normally done lazily by ImGui_ImplOpenGL3_NewFrame, but once the renderer is attached the
+    // context belongs to the render thread. Only the draw data goes there after this.
+    ImGui_ImplOpenGL3_CreateDeviceObjects();
+#endif
+
     ecs_singleton_set(it->world, ImguiContext, {.io = imgui, editor_font = editor_font});
 }
 
@@ -38,16 +52,76 @@ static void ImguiNewFrame(ecs_iter_t* it)
         SDL_GetWindowSize(window[i].window, &win_w, &win_h);
         imgui[i].io->DisplaySize = (ImVec2){.x = (float)win_w, .y = (float)win_h};
         imgui[i].io->DeltaTime = it->delta_time;
-        ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplSDL2_NewFrame(window->window);
         igNewFrame();
     }
 }
 
+// The draw data of a frame copied into a single allocation, each buffer starts 8 byte aligned.
+// Only the buffers the OpenGL backend reads are copied so the render thread never has to touch
+// imgui's allocator or context.
+static ImDrawData* copy_draw_data(const ImDrawData* src)
+{
+    const int32_t count = src->CmdListsCount;
+
+    size_t size = sizeof(ImDrawData) + (sizeof(ImDrawList*) + sizeof(ImDrawList)) * count;
+    for (int32_t i = 0; i < count; ++i) {
+        const ImDrawList* list = src->CmdLists[i];
+        size += sizeof(ImDrawCmd) * list->CmdBuffer.Size;
+        size += (sizeof(ImDrawVert) * list->VtxBuffer.Size + 7) & ~(size_t)7;
+        size += (sizeof(ImDrawIdx) * list->IdxBuffer.Size + 7) & ~(size_t)7;
+    }
+
+    uint8_t* block = malloc(size);
+    ImDrawData* dst = (ImDrawData*)block;
+    ImDrawList** lists = (ImDrawList**)(dst + 1);
+    ImDrawList* list_data = (ImDrawList*)(lists + count);
+    uint8_t* buffers = (uint8_t*)(list_data + count);
+
+    *dst = *src;
+    dst->CmdLists = lists;
+
+    for (int32_t i = 0; i < count; ++i) {
+        const ImDrawList* list = src->CmdLists[i];
+        ImDrawList* copy = &list_data[i];
+        memset(copy, 0, sizeof(ImDrawList));
+        lists[i] = copy;
+
+        // commands first, they're the only buffer with pointers in it
+        copy->CmdBuffer.Size = copy->CmdBuffer.Capacity = list->CmdBuffer.Size;
+        copy->CmdBuffer.Data = (ImDrawCmd*)buffers;
+        memcpy(buffers, list->CmdBuffer.Data, sizeof(ImDrawCmd) * list->CmdBuffer.Size);
+        buffers += sizeof(ImDrawCmd) * list->CmdBuffer.Size;
+
+        copy->VtxBuffer.Size = copy->VtxBuffer.Capacity = list->VtxBuffer.Size;
+        copy->VtxBuffer.Data = (ImDrawVert*)buffers;
+        memcpy(buffers, list->VtxBuffer.Data, sizeof(ImDrawVert) * list->VtxBuffer.Size);
+        buffers += (sizeof(ImDrawVert) * list->VtxBuffer.Size + 7) & ~(size_t)7;
+
+        copy->IdxBuffer.Size = copy->IdxBuffer.Capacity = list->IdxBuffer.Size;
+        copy->IdxBuffer.Data = (ImDrawIdx*)buffers;
+        memcpy(buffers, list->IdxBuffer.Data, sizeof(ImDrawIdx) * list->IdxBuffer.Size);
+        buffers += (sizeof(ImDrawIdx) * list->IdxBuffer.Size + 7) & ~(size_t)7;
+    }
+
+    return dst;
+}
+
+// render thread
+static void render_draw_data(void* data)
+{
+    ImDrawData* draw_data = *(ImDrawData**)data;
+    ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+    free(draw_data);
+}
+
 static void ImguiRender(ecs_iter_t* it)
 {
     igRender();
-    ImGui_ImplOpenGL3_RenderDrawData(igGetDrawData());
+#if !CRYPT_HEADLESS
+    ImDrawData* draw_data = copy_draw_data(igGetDrawData());
+    render_cmd_push(RenderCmdStage_Overlay, render_draw_data, &draw_data, sizeof(ImDrawData*));
+#endif
 }
 
 void on_sdl2_event(const SDL_Event* event)
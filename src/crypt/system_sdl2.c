@@ -59,7 +59,12 @@ static void Sdl2CreateWindow(ecs_iter_t* it)
 
         const char* title = (window_desc[i].title) ? window_desc[i].title : "SDL2 Window";
 
+#if CRYPT_HEADLESS
+        // nothing is presented, the window only exists for the systems that expect one
+        uint32_t flags = SDL_WINDOW_HIDDEN;
+#else
         uint32_t flags = SDL_WINDOW_OPENGL;
+#endif
 
         if (window_desc->fullscreen) {
             flags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
@@ -102,6 +107,10 @@ static void Sdl2CreateGlContext(ecs_iter_t* it)
     for (int32_t i = 0; i < it->count; ++i) {
         ecs_entity_t e = it->entities[i];
 
+#if CRYPT_HEADLESS
+        // sokol's dummy backend doesn't need a context
+        ecs_set(it->world, e, Sdl2GlContext, {.gl = NULL});
+#else
         ecs_set(
             it->world,
             it->entities[i],
@@ -112,6 +121,7 @@ static void Sdl2CreateGlContext(ecs_iter_t* it)
             ecs_err("Gl3w failed to init.");
             break;
         }
+#endif
     }
 }
 
@@ -120,7 +130,9 @@ static void Sdl2DestroyGLContext(ecs_iter_t* it)
     Sdl2GlContext* context = ecs_term(it, Sdl2GlContext, 1);
 
     for (int32_t i = 0; i < it->count; ++i) {
-        SDL_GL_DeleteContext(context[i].gl);
+        if (context[i].gl) {
+            SDL_GL_DeleteContext(context[i].gl);
+        }
     }
 }
 
@@ -133,15 +145,6 @@ static void Sdl2DestroyWindow(ecs_iter_t* it)
     }
 }
 
-static void Sdl2SwapWindow(ecs_iter_t* it)
-{
-    Sdl2Window* window = ecs_term(it, Sdl2Window, 1);
-
-    for (int32_t i = 0; i < it->count; ++i) {
-        SDL_GL_SwapWindow(window[i].window);
-    }
-}
-
 void SystemSdl2Import(ecs_world_t* world)
 {
     ECS_MODULE(world, SystemSdl2);
@@ -175,6 +178,7 @@ void SystemSdl2Import(ecs_world_t* world)
         [in] system.sdl2.WindowConfig,
         [out] :system.sdl2.Window);
 
+    // the sprite renderer takes the context over to its render thread, which also swaps
     ECS_SYSTEM(world, Sdl2CreateGlContext, EcsOnSet,
         [in] system.sdl2.Window,
         [out] :system.sdl2.GlContext);
@@ -182,7 +186,6 @@ void SystemSdl2Import(ecs_world_t* world)
 
     ECS_SYSTEM(world, Sdl2DestroyWindow, EcsUnSet, Sdl2Window);
     ECS_SYSTEM(world, Sdl2DestroyGLContext, EcsUnSet, Sdl2GlContext);
-    ECS_SYSTEM(world, Sdl2SwapWindow, EcsPostFrame, Sdl2Window, Sdl2GlContext);
 
     ECS_EXPORT_COMPONENT(Sdl2Input);
     ECS_EXPORT_COMPONENT(WindowConfig);
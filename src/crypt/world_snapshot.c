@@ -0,0 +1,378 @@
+#include "world_snapshot.h"
+#include "scene.h"
+#include "stb_ds.h"
+#include "tx_types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct snapshot_table {
+    ecs_table_t* table;
+    int32_t count;
+    uint32_t entities_offset;
+    int32_t first_column;
+    int32_t column_count;
+    // restore bookkeeping, whether the table still holds exactly the captured entities
+    bool intact;
+    bool seen;
+};
+
+struct snapshot_column {
+    ecs_id_t id;
+    int32_t index; // column in the table
+    int32_t size;
+    uint32_t offset;
+    int32_t ref; // into desc.refs or -1
+};
+
+// old to new id of recreated entities
+struct snapshot_remap {
+    ecs_entity_t key;
+    ecs_entity_t value;
+};
+
+struct world_snapshot {
+    world_snapshot_desc desc;
+    ecs_query_t* queries[K_WORLD_SNAPSHOT_MAX_QUERIES];
+    int32_t query_count;
+
+    struct snapshot_table* tables;
+    struct snapshot_column* columns;
+    uint8_t* data;
+    int32_t entity_count;
+};
+
+world_snapshot* world_snapshot_new(ecs_world_t* world, const world_snapshot_desc* desc)
+{
+    world_snapshot* snapshot = calloc(1, sizeof(world_snapshot));
+    snapshot->desc = *desc;
+
+    for (int32_t q = 0; q < K_WORLD_SNAPSHOT_MAX_QUERIES && desc->queries[q]; ++q) {
+        snapshot->queries[snapshot->query_count++] = ecs_query_new(world, desc->queries[q]);
+    }
+
+    return snapshot;
+}
+
+void world_snapshot_free(world_snapshot* snapshot)
+{
+    if (!snapshot) {
+        return;
+    }
+
+    for (int32_t q = 0; q < snapshot->query_count; ++q) {
+        ecs_query_free(snapshot->queries[q]);
+    }
+    arrfree(snapshot->tables);
+    arrfree(snapshot->columns);
+    arrfree(snapshot->data);
+    free(snapshot);
+}
+
+static struct snapshot_table* snapshot_find_table(world_snapshot* snapshot, ecs_table_t* table)
+{
+    for (int32_t t = 0; t < arrlen(snapshot->tables); ++t) {
+        if (snapshot->tables[t].table == table) {
+            return &snapshot->tables[t];
+        }
+    }
+    return NULL;
+}
+
+static bool snapshot_wants(ecs_world_t* world, const world_snapshot* snapshot, ecs_id_t id)
+{
+    if (ecs_component_has_actions(world, ecs_get_typeid(world, id))) {
+        return false;
+    }
+    if (snapshot->desc.components[0] == 0) {
+        return true;
+    }
+    for (int32_t c = 0; c < K_WORLD_SNAPSHOT_MAX_COMPONENTS && snapshot->desc.components[c]; ++c) {
+        if (snapshot->desc.components[c] == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int32_t snapshot_find_ref(const world_snapshot* snapshot, ecs_id_t id)
+{
+    for (int32_t r = 0; r < K_WORLD_SNAPSHOT_MAX_REFS && snapshot->desc.refs[r].component; ++r) {
+        if (snapshot->desc.refs[r].component == id) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+static uint32_t snapshot_push(world_snapshot* snapshot, const void* src, size_t size)
+{
+    const uint32_t offset = (uint32_t)arrlen(snapshot->data);
+    memcpy(arraddnptr(snapshot->data, size), src, size);
+    return offset;
+}
+
+void world_snapshot_capture(ecs_world_t* world, world_snapshot* snapshot)
+{
+    arrsetlen(snapshot->tables, 0);
+    arrsetlen(snapshot->columns, 0);
+    arrsetlen(snapshot->data, 0);
+    snapshot->entity_count = 0;
+
+    for (int32_t q = 0; q < snapshot->query_count; ++q) {
+        ecs_iter_t it = ecs_query_iter(snapshot->queries[q]);
+        while (ecs_query_next(&it)) {
+            ecs_table_t* table = it.table->table;
+            if (it.count == 0 || snapshot_find_table(snapshot, table)) {
+                continue;
+            }
+
+            struct snapshot_table entry = {
+                .table = table,
+                .count = it.count,
+                .entities_offset =
+                    snapshot_push(snapshot, it.entities, sizeof(ecs_entity_t) * it.count),
+                .first_column = (int32_t)arrlen(snapshot->columns),
+            };
+
+            ecs_type_t type = ecs_iter_type(&it);
+            const ecs_id_t* ids = ecs_vector_first(type, ecs_id_t);
+            for (int32_t c = 0; c < ecs_vector_count(type); ++c) {
+                const size_t size = ecs_iter_column_size(&it, c);
+                if (size == 0 || !snapshot_wants(world, snapshot, ids[c])) {
+                    continue;
+                }
+
+                struct snapshot_column column = {
+                    .id = ids[c],
+                    .index = c,
+                    .size = (int32_t)size,
+                    .offset = snapshot_push(
+                        snapshot, ecs_iter_column_w_size(&it, size, c), size * it.count),
+                    .ref = snapshot_find_ref(snapshot, ids[c]),
+                };
+                arrput(snapshot->columns, column);
+                ++entry.column_count;
+            }
+
+            arrput(snapshot->tables, entry);
+            snapshot->entity_count += it.count;
+        }
+    }
+}
+
+static bool snapshot_entities_eq(
+    const world_snapshot* snapshot, const struct snapshot_table* table, const ecs_iter_t* it)
+{
+    return table->count == it->count
+           && memcmp(
+                  snapshot->data + table->entities_offset,
+                  it->entities,
+                  sizeof(ecs_entity_t) * it->count)
+                  == 0;
+}
+
+// Deletes the current entities of changed tables and the captured entities of those tables that
+// are still alive somewhere else.
+static void snapshot_delete_changed(ecs_world_t* world, world_snapshot* snapshot)
+{
+    ecs_entity_t* doomed = NULL;
+
+    for (int32_t q = 0; q < snapshot->query_count; ++q) {
+        ecs_iter_t it = ecs_query_iter(snapshot->queries[q]);
+        while (ecs_query_next(&it)) {
+            struct snapshot_table* table = snapshot_find_table(snapshot, it.table->table);
+            if (!table || !table->intact) {
+                memcpy(arraddnptr(doomed, it.count), it.entities, sizeof(ecs_entity_t) * it.count);
+            }
+        }
+    }
+
+    for (int32_t t = 0; t < arrlen(snapshot->tables); ++t) {
+        const struct snapshot_table* table = &snapshot->tables[t];
+        if (table->intact) {
+            continue;
+        }
+        const ecs_entity_t* entities = (ecs_entity_t*)(snapshot->data + table->entities_offset);
+        for (int32_t i = 0; i < table->count; ++i) {
+            arrput(doomed, entities[i]);
+        }
+    }
+
+    // on remove triggers can delete entities further down the list
+    for (int32_t i = 0; i < arrlen(doomed); ++i) {
+        if (ecs_is_alive(world, doomed[i])) {
+            ecs_delete(world, doomed[i]);
+        }
+    }
+
+    arrfree(doomed);
+}
+
+static bool snapshot_has_actions(ecs_world_t* world, const ecs_id_t* ids, int32_t id_count)
+{
+    for (int32_t c = 0; c < id_count; ++c) {
+        const ecs_entity_t component = ecs_get_typeid(world, ids[c]);
+        if (component && ecs_component_has_actions(world, component)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Spawns the captured entities of every changed table and returns the old to new id mapping.
+static void snapshot_respawn_changed(
+    ecs_world_t* world,
+    world_snapshot* snapshot,
+    struct snapshot_remap** remap)
+{
+    for (int32_t t = 0; t < arrlen(snapshot->tables); ++t) {
+        struct snapshot_table* table = &snapshot->tables[t];
+        if (table->intact) {
+            continue;
+        }
+
+        ecs_type_t type = ecs_table_get_type(table->table);
+        const ecs_id_t* ids = ecs_vector_first(type, ecs_id_t);
+        const int32_t id_count = ecs_vector_count(type);
+        TX_ASSERT(id_count <= K_SCENE_MAX_COLUMNS);
+
+        // references are set once everything has its new id
+        scene_column columns[K_SCENE_MAX_COLUMNS];
+        for (int32_t c = 0; c < id_count; ++c) {
+            columns[c] = (scene_column){.id = ids[c]};
+        }
+        for (int32_t c = table->first_column; c < table->first_column + table->column_count; ++c) {
+            const struct snapshot_column* column = &snapshot->columns[c];
+            if (column->ref < 0) {
+                columns[column->index].size = column->size;
+                columns[column->index].data = snapshot->data + column->offset;
+            }
+        }
+
+        const ecs_entity_t* spawned = NULL;
+        if (snapshot_has_actions(world, ids, id_count)) {
+            // the columns that weren't captured can't be left to a bulk copy, the whole type is
+            // created (and constructed) first and only the captured values are set on top
+            spawned = ecs_bulk_new_w_type(world, type, table->count);
+            for (int32_t c = 0; c < id_count; ++c) {
+                if (!columns[c].data) {
+                    continue;
+                }
+                const uint8_t* value = columns[c].data;
+                for (int32_t i = 0; i < table->count; ++i, value += columns[c].size) {
+                    ecs_set_id(world, spawned[i], columns[c].id, columns[c].size, value);
+                }
+            }
+        } else {
+            spawned = scene_spawn(world, columns, id_count, table->count);
+        }
+
+        ecs_entity_t* entities = (ecs_entity_t*)(snapshot->data + table->entities_offset);
+        for (int32_t i = 0; i < table->count; ++i) {
+            hmput(*remap, entities[i], spawned[i]);
+            entities[i] = spawned[i];
+        }
+    }
+}
+
+static void snapshot_remap_refs(
+    ecs_world_t* world,
+    world_snapshot* snapshot,
+    struct snapshot_remap* remap)
+{
+    for (int32_t t = 0; t < arrlen(snapshot->tables); ++t) {
+        const struct snapshot_table* table = &snapshot->tables[t];
+        const ecs_entity_t* entities = (ecs_entity_t*)(snapshot->data + table->entities_offset);
+
+        for (int32_t c = table->first_column; c < table->first_column + table->column_count; ++c) {
+            const struct snapshot_column* column = &snapshot->columns[c];
+            if (column->ref < 0) {
+                continue;
+            }
+
+            uint8_t* value = snapshot->data + column->offset;
+            const uint32_t offset = snapshot->desc.refs[column->ref].offset;
+            for (int32_t i = 0; i < table->count; ++i, value += column->size) {
+                ecs_entity_t* ref = (ecs_entity_t*)(value + offset);
+                const ptrdiff_t index = hmgeti(remap, *ref);
+                if (index >= 0) {
+                    *ref = remap[index].value;
+                }
+                // intact tables get the remapped values with the rest of their columns
+                if (!table->intact) {
+                    ecs_set_id(world, entities[i], column->id, column->size, value);
+                }
+            }
+        }
+    }
+}
+
+void world_snapshot_restore(ecs_world_t* world, world_snapshot* snapshot)
+{
+    bool intact = true;
+    for (int32_t t = 0; t < arrlen(snapshot->tables); ++t) {
+        snapshot->tables[t].intact = false;
+        snapshot->tables[t].seen = false;
+    }
+
+    for (int32_t q = 0; q < snapshot->query_count; ++q) {
+        ecs_iter_t it = ecs_query_iter(snapshot->queries[q]);
+        while (ecs_query_next(&it)) {
+            struct snapshot_table* table = snapshot_find_table(snapshot, it.table->table);
+            if (!table) {
+                intact &= it.count == 0;
+                continue;
+            }
+            if (!table->seen) {
+                table->seen = true;
+                table->intact = snapshot_entities_eq(snapshot, table, &it);
+            }
+        }
+    }
+    for (int32_t t = 0; t < arrlen(snapshot->tables); ++t) {
+        intact &= snapshot->tables[t].intact;
+    }
+
+    if (!intact) {
+        struct snapshot_remap* remap = NULL;
+
+        snapshot_delete_changed(world, snapshot);
+        snapshot_respawn_changed(world, snapshot, &remap);
+        snapshot_remap_refs(world, snapshot, remap);
+
+        hmfree(remap);
+    }
+
+    // one copy per column for the tables that kept their entities
+    for (int32_t q = 0; q < snapshot->query_count; ++q) {
+        ecs_iter_t it = ecs_query_iter(snapshot->queries[q]);
+        while (ecs_query_next(&it)) {
+            struct snapshot_table* table = snapshot_find_table(snapshot, it.table->table);
+            if (!table || !table->intact || !table->seen) {
+                continue;
+            }
+            // a table matched by more than one query is only copied once
+            table->seen = false;
+
+            for (int32_t c = table->first_column; c < table->first_column + table->column_count;
+                 ++c) {
+                const struct snapshot_column* column = &snapshot->columns[c];
+                memcpy(
+                    ecs_iter_column_w_size(&it, column->size, column->index),
+                    snapshot->data + column->offset,
+                    (size_t)column->size * table->count);
+            }
+        }
+    }
+}
+
+int32_t world_snapshot_entity_count(const world_snapshot* snapshot)
+{
+    return snapshot->entity_count;
+}
+
+size_t world_snapshot_size(const world_snapshot* snapshot)
+{
+    return (size_t)arrlen(snapshot->data);
+}
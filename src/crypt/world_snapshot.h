@@ -0,0 +1,56 @@
+// world_snapshot.h - World Snapshots
+// Captures the entities of every table matched by a set of queries, their ids and component
+// columns packed into one buffer, so a known state can be put back later: restarting a wave,
+// rolling back a replay or resetting a benchmark scenario.
+//
+// Restoring tables that still hold exactly the captured entities is one memcpy per column and runs
+// no OnSet systems. Tables whose entities changed (some were deleted, moved to another table or
+// created since) have their current entities deleted and the captured ones recreated with one bulk
+// spawn per table. Recreated entities get new ids, members listed in world_snapshot_desc.refs are
+// patched to follow them and the snapshot updates itself so the next restore can take the fast
+// path again.
+//
+// Only plain data columns are captured. Components with lifecycle actions (EcsName for one) can't
+// be copied byte for byte, recreated entities get them default constructed. Tables holding such
+// components are recreated with their full type first and the captured values set one by one.
+
+#pragma once
+
+#include "flecs.h"
+
+#include <stddef.h>
+
+enum {
+    K_WORLD_SNAPSHOT_MAX_QUERIES = 4,
+    K_WORLD_SNAPSHOT_MAX_COMPONENTS = 16,
+    K_WORLD_SNAPSHOT_MAX_REFS = 8,
+};
+
+// ecs_entity_t member at offset inside component that points at another captured entity
+typedef struct world_snapshot_ref {
+    ecs_id_t component;
+    uint32_t offset;
+} world_snapshot_ref;
+
+typedef struct world_snapshot_desc {
+    // query signatures, tables matched by any of them are captured
+    const char* queries[K_WORLD_SNAPSHOT_MAX_QUERIES];
+    // columns to capture, every plain data column when left empty
+    ecs_id_t components[K_WORLD_SNAPSHOT_MAX_COMPONENTS];
+    world_snapshot_ref refs[K_WORLD_SNAPSHOT_MAX_REFS];
+} world_snapshot_desc;
+
+typedef struct world_snapshot world_snapshot;
+
+// Creates the queries, nothing is captured until world_snapshot_capture.
+world_snapshot* world_snapshot_new(ecs_world_t* world, const world_snapshot_desc* desc);
+void world_snapshot_free(world_snapshot* snapshot);
+
+// Replaces the captured state with the current one, reusing the snapshot's memory.
+void world_snapshot_capture(ecs_world_t* world, world_snapshot* snapshot);
+// Works from inside systems too, structural changes are deferred like any other.
+void world_snapshot_restore(ecs_world_t* world, world_snapshot* snapshot);
+
+int32_t world_snapshot_entity_count(const world_snapshot* snapshot);
+// bytes of captured ids and component data
+size_t world_snapshot_size(const world_snapshot* snapshot);